@@ -0,0 +1,825 @@
+#include "BehaviourChecks.h"
+#include "PluginProcessor.h"
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+//==============================================================================
+// Counts failures and prints one line per check, in the golden render format
+struct CheckReport
+{
+    int numFailed{ 0 };
+
+    void expect(bool passed, const juce::String& name, double value)
+    {
+        std::printf("%-4s %-40s %.6g\n", passed ? "ok" : "FAIL", name.toRawUTF8(), value);
+
+        if (!passed)
+            ++numFailed;
+    }
+};
+
+static constexpr double check_sample_rate = 48000.0;
+
+// Where the crossfade and feedback checks change their tap or input, well
+// after the line has filled and the parameters have settled
+static constexpr int settle_length = 24000;
+
+static juce::RangedAudioParameter* findParameter(juce::AudioProcessor& processor, const juce::String& id)
+{
+    for (auto* param : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+            if (ranged->paramID == id)
+                return ranged;
+
+    return nullptr;
+}
+
+static void setPlainValue(juce::AudioProcessor& processor, const juce::String& id, float value)
+{
+    if (auto* param = findParameter(processor, id))
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+// One render through a fresh processor
+struct RenderSetup
+{
+    juce::AudioChannelSet layout = juce::AudioChannelSet::stereo();
+    int inputChannels{ 1 };
+    std::map<juce::String, float> values;
+    bool isRealtime{ false };
+    bool isDouble{ false };
+    int blockSize{ 256 };
+    int numSamples{ 2048 };
+
+    // Input sample of each channel, a constant 0.5 if not set
+    std::function<double(int channel, int sample)> input;
+
+    // Called before every block with the position of its first sample
+    std::function<void(juce::AudioProcessor&, int position)> update;
+};
+
+// Reproducible white noise between -0.5 and 0.5
+static double noise(int channel, int sample)
+{
+    auto hash = static_cast<juce::uint32>(sample) * 2654435761u + static_cast<juce::uint32>(channel) * 40503u;
+    hash ^= hash >> 15;
+    hash *= 2246822519u;
+    hash ^= hash >> 13;
+    return static_cast<double>(hash) / 4294967296.0 - 0.5;
+}
+
+template <typename SampleType>
+static void renderBlocks(juce::AudioProcessor& processor, const RenderSetup& setup, juce::AudioBuffer<double>& output)
+{
+    juce::AudioBuffer<SampleType> buffer(setup.layout.size(), setup.blockSize);
+    juce::MidiBuffer midi;
+
+    for (int position = 0; position < setup.numSamples; position += setup.blockSize)
+    {
+        auto numSamples = juce::jmin(setup.blockSize, setup.numSamples - position);
+        buffer.setSize(setup.layout.size(), numSamples, false, false, true);
+        buffer.clear();
+
+        if (setup.update)
+            setup.update(processor, position);
+
+        for (int channel = 0; channel < setup.inputChannels; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample(channel, i, static_cast<SampleType>(setup.input ? setup.input(channel, position + i) : 0.5));
+
+        processor.processBlock(buffer, midi);
+
+        for (int channel = 0; channel < setup.layout.size(); ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                output.setSample(channel, position + i, static_cast<double>(buffer.getSample(channel, i)));
+    }
+}
+
+// In realtime the delay line only grows in the background, so it is sized
+// for the longest Delay Time up front, as the golden renders do
+static juce::AudioBuffer<double> render(const RenderSetup& setup)
+{
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+    processor->setNonRealtime(!setup.isRealtime);
+    processor->setProcessingPrecision(setup.isDouble ? juce::AudioProcessor::doublePrecision
+                                                     : juce::AudioProcessor::singlePrecision);
+    processor->setPlayConfigDetails(setup.inputChannels, setup.layout.size(), check_sample_rate, setup.blockSize);
+
+    for (int i = 0; i < num_delays && setup.isRealtime; ++i)
+        setPlainValue(*processor, "delay" + juce::String(i + 1), 4000.0f);
+
+    processor->prepareToPlay(check_sample_rate, setup.blockSize);
+
+    for (int i = 0; i < num_delays; ++i)
+        setPlainValue(*processor, "delay" + juce::String(i + 1), 250.0f);
+
+    for (auto& value : setup.values)
+        setPlainValue(*processor, value.first, value.second);
+
+    juce::AudioBuffer<double> output(setup.layout.size(), setup.numSamples);
+
+    if (setup.isDouble)
+        renderBlocks<double>(*processor, setup, output);
+    else
+        renderBlocks<float>(*processor, setup, output);
+
+    processor->releaseResources();
+    return output;
+}
+
+// Six taps using feedback, cross, filters, delay and pan LFOs and every
+// interpolation kernel
+static void setEveryPath(RenderSetup& setup)
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        auto tap = juce::String(i + 1);
+        setup.values["gain" + tap] = 40.0f + 10.0f * static_cast<float>(i);
+        setup.values["delay" + tap] = 17.0f + 53.3f * static_cast<float>(i);
+        setup.values["pan" + tap] = static_cast<float>(i * 19);
+        setup.values["fdbk" + tap] = i % 2 == 0 ? 45.0f : 0.0f;
+        setup.values["lpf" + tap] = 6000.0f;
+        setup.values["hpf" + tap] = 80.0f;
+        setup.values["depth" + tap] = i % 3 == 0 ? 2.0f : 0.0f;
+        setup.values["panMod" + tap] = i == 4 ? 60.0f : 0.0f;
+        setup.values["interp" + tap] = static_cast<float>(i % 4);
+    }
+
+    setup.values["cross"] = 30.0f;
+    setup.values["blend"] = 70.0f;
+}
+
+//==============================================================================
+static void checkLayout(CheckReport& report, const juce::String& name, const juce::AudioChannelSet& layout)
+{
+    ChannelPanner panner;
+    panner.setLayout(layout);
+
+    auto numChannels = layout.size();
+    auto lfe = layout.getChannelIndexForType(juce::AudioChannelSet::LFE);
+    auto centre = layout.getChannelIndexForType(juce::AudioChannelSet::centre);
+
+    // Every pan is equal power over at most two speakers, never the LFE
+    auto maxPowerError = 0.0;
+    auto maxFed = 0;
+    auto lfeGain = 0.0f;
+
+    for (int step = 0; step <= 1000; ++step)
+    {
+        float gains [ChannelPanner::max_channels];
+        panner.getGains(static_cast<float>(step) / 1000.0f, 1.0f, gains);
+
+        auto power = 0.0;
+        auto numFed = 0;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            power += juce::square(static_cast<double>(gains[channel]));
+            numFed += gains[channel] != 0.0f ? 1 : 0;
+        }
+
+        maxPowerError = juce::jmax(maxPowerError, std::abs(power - 1.0));
+        maxFed = juce::jmax(maxFed, numFed);
+        lfeGain = juce::jmax(lfeGain, lfe >= 0 ? gains[lfe] : 0.0f);
+    }
+
+    report.expect(maxPowerError < 1.0e-5, name + " pan power error", maxPowerError);
+    report.expect(maxFed <= 2, name + " speakers per pan", maxFed);
+    report.expect(lfeGain == 0.0f, name + " pan gain on LFE", lfeGain);
+
+    // The centre of the sweep is the centre speaker
+    float gains [ChannelPanner::max_channels];
+    panner.getGains(0.5f, 1.0f, gains);
+    report.expect(centre >= 0 && gains[centre] == 1.0f, name + " centre pan on centre", centre >= 0 ? gains[centre] : 0.0f);
+
+    // A mono input's dry signal is heard on the centre speaker alone
+    RenderSetup dry;
+    dry.layout = layout;
+    dry.values = { { "blend", 0.0f } };
+
+    auto output = render(dry);
+    auto straySum = 0.0;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        if (channel != centre)
+            straySum += output.getMagnitude(channel, 0, output.getNumSamples());
+
+    report.expect(std::abs(output.getSample(centre, 2047) - 0.5) < 1.0e-6, name + " dry on centre", output.getSample(centre, 2047));
+    report.expect(straySum == 0.0, name + " dry on other speakers", straySum);
+
+    // A tap panned between two speakers is heard on those two only
+    RenderSetup tap;
+    tap.layout = layout;
+    tap.values = { { "blend", 100.0f }, { "gain1", 100.0f }, { "delay1", 0.0f }, { "pan1", 33.0f } };
+
+    auto wet = render(tap);
+    auto numFed = 0;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        numFed += wet.getMagnitude(channel, 1024, 1024) > 0.0 ? 1 : 0;
+
+    report.expect(numFed == 2, name + " tap speakers", numFed);
+    report.expect(lfe < 0 || wet.getMagnitude(lfe, 0, 2048) == 0.0, name + " tap on LFE",
+        lfe >= 0 ? wet.getMagnitude(lfe, 0, 2048) : 0.0);
+}
+
+int runPannerChecks()
+{
+    CheckReport report;
+
+    checkLayout(report, "5.1", juce::AudioChannelSet::create5point1());
+    checkLayout(report, "7.1.4", juce::AudioChannelSet::create7point1point4());
+
+    // Without a centre speaker the dry signal stays on the front pair, as
+    // in stereo
+    ChannelPanner stereo, quad;
+    stereo.setLayout(juce::AudioChannelSet::stereo());
+    quad.setLayout(juce::AudioChannelSet::quadraphonic());
+
+    report.expect(stereo.getDryGain(0) == 1.0f && stereo.getDryGain(1) == 1.0f, "stereo dry on left and right", stereo.getDryGain(0));
+    report.expect(quad.getDryGain(0) == 1.0f && quad.getDryGain(1) == 1.0f && quad.getDryGain(2) == 0.0f
+        && quad.getDryGain(3) == 0.0f, "quad dry on front pair", quad.getDryGain(2));
+
+    std::printf("%d panner checks failed\n", report.numFailed);
+    return report.numFailed;
+}
+
+//==============================================================================
+// Offline renders take larger pieces and split the taps into more channel
+// groups, which must not change a single sample
+static void checkOfflineMatches(CheckReport& report, const juce::String& name, const juce::AudioChannelSet& layout)
+{
+    RenderSetup setup;
+    setup.layout = layout;
+    setup.inputChannels = layout.size();
+    setup.input = noise;
+    setup.numSamples = 48000;
+    setEveryPath(setup);
+
+    setup.isRealtime = true;
+    setup.blockSize = 256;
+    auto realtime = render(setup);
+
+    setup.isRealtime = false;
+    setup.blockSize = 3000;
+    auto offline = render(setup);
+
+    auto numDifferent = 0;
+
+    for (int channel = 0; channel < layout.size(); ++channel)
+        for (int i = 0; i < setup.numSamples; ++i)
+            numDifferent += realtime.getSample(channel, i) != offline.getSample(channel, i) ? 1 : 0;
+
+    report.expect(numDifferent == 0, name + " offline samples differing", numDifferent);
+}
+
+// @return - Channel groups a processor prepared for layout renders its taps in
+static int getNumTapGroups(const juce::AudioChannelSet& layout, bool isRealtime)
+{
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+    processor->setNonRealtime(!isRealtime);
+    processor->setPlayConfigDetails(layout.size(), layout.size(), check_sample_rate, 256);
+    processor->prepareToPlay(check_sample_rate, 256);
+
+    auto numGroups = dynamic_cast<SequencedDelay&>(*processor).getNumTapGroups();
+    processor->releaseResources();
+    return numGroups;
+}
+
+int runOfflineChecks()
+{
+    CheckReport report;
+
+    checkOfflineMatches(report, "stereo", juce::AudioChannelSet::stereo());
+    checkOfflineMatches(report, "7.1.4", juce::AudioChannelSet::create7point1point4());
+
+    // Offline every output channel gets its own group, as far as the cores go
+    auto layout = juce::AudioChannelSet::create7point1point4();
+    auto numCpus = juce::SystemStats::getNumCpus();
+    auto offlineGroups = getNumTapGroups(layout, false);
+    auto realtimeGroups = getNumTapGroups(layout, true);
+
+    report.expect(offlineGroups == juce::jmin(layout.size(), numCpus), "7.1.4 offline groups", offlineGroups);
+    report.expect(realtimeGroups <= offlineGroups, "7.1.4 realtime groups no more", realtimeGroups);
+
+    std::printf("%d offline checks failed\n", report.numFailed);
+    return report.numFailed;
+}
+
+//==============================================================================
+// @return - Largest difference between the two processors' parameters, on
+//           the normalised range
+static float compareParameters(juce::AudioProcessor& a, juce::AudioProcessor& b)
+{
+    auto& paramsA = a.getParameters();
+    auto& paramsB = b.getParameters();
+
+    if (paramsA.size() != paramsB.size())
+        return 1.0f;
+
+    auto maxDifference = 0.0f;
+
+    for (int i = 0; i < paramsA.size(); ++i)
+        maxDifference = juce::jmax(maxDifference, std::abs(paramsA[i]->getValue() - paramsB[i]->getValue()));
+
+    return maxDifference;
+}
+
+// The XML state earlier versions saved, the tree copyState produces
+static void writeXmlState(juce::AudioProcessor& processor, juce::MemoryBlock& dest)
+{
+    juce::ValueTree state("Main");
+
+    for (auto* param : processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+        {
+            juce::ValueTree child("PARAM");
+            child.setProperty("id", ranged->paramID, nullptr);
+            child.setProperty("value", ranged->convertFrom0to1(ranged->getValue()), nullptr);
+            state.appendChild(child, nullptr);
+        }
+    }
+
+    std::unique_ptr<juce::XmlElement> xml(state.createXml());
+    juce::AudioProcessor::copyXmlToBinary(*xml, dest);
+}
+
+int runStateChecks()
+{
+    CheckReport report;
+
+    // Every parameter off its default, so nothing matches by accident
+    std::unique_ptr<juce::AudioProcessor> saved(createPluginFilter());
+    juce::Random random(0x57a7e);
+
+    for (auto* param : saved->getParameters())
+        param->setValueNotifyingHost(random.nextFloat());
+
+    juce::MemoryBlock binary, xml;
+    saved->getStateInformation(binary);
+    writeXmlState(*saved, xml);
+
+    auto load = [] (const void* data, size_t size)
+    {
+        std::unique_ptr<juce::AudioProcessor> loaded(createPluginFilter());
+        loaded->setStateInformation(data, static_cast<int>(size));
+        return loaded;
+    };
+
+    std::unique_ptr<juce::AudioProcessor> defaults(createPluginFilter());
+
+    // Loading converts each stored value back to the normalised range,
+    // which skewed ranges round
+    auto roundTrip = load(binary.getData(), binary.getSize());
+    report.expect(compareParameters(*saved, *roundTrip) < 1.0e-6f, "binary round trip",
+        compareParameters(*saved, *roundTrip));
+
+    auto fromXml = load(xml.getData(), xml.getSize());
+    report.expect(compareParameters(*saved, *fromXml) < 1.0e-6f, "xml state load",
+        compareParameters(*saved, *fromXml));
+
+    // Rejected states leave every parameter at its default
+    for (auto size : { binary.getSize() - 1, binary.getSize() / 2, static_cast<size_t>(8) })
+    {
+        auto truncated = load(binary.getData(), size);
+        report.expect(compareParameters(*defaults, *truncated) == 0.0f,
+            "truncated to " + juce::String(static_cast<int>(size)) + " bytes", compareParameters(*defaults, *truncated));
+    }
+
+    juce::MemoryBlock newer(binary);
+    auto newerVersion = juce::ByteOrder::swapIfBigEndian(StateFormat::version + 1);
+    newer.copyFrom(&newerVersion, 4, 4);
+
+    auto fromNewer = load(newer.getData(), newer.getSize());
+    report.expect(compareParameters(*defaults, *fromNewer) == 0.0f, "newer version", compareParameters(*defaults, *fromNewer));
+
+    // A value that is not finite, here the sixth entry's, rejects the whole
+    // state
+    juce::MemoryBlock notFinite(binary);
+    auto nan = std::numeric_limits<float>::quiet_NaN();
+    notFinite.copyFrom(&nan, 12 + 8 * 5 + 4, 4);
+
+    auto fromNotFinite = load(notFinite.getData(), notFinite.getSize());
+    report.expect(compareParameters(*defaults, *fromNotFinite) == 0.0f, "non-finite value", compareParameters(*defaults, *fromNotFinite));
+
+    // A parameter left out of a state goes back to its default, as XML
+    // states do, however it was set before
+    auto* omitted = findParameter(*saved, "gain3");
+    auto omittedHash = juce::ByteOrder::swapIfBigEndian(StateFormat::getHash("gain3"));
+    auto numEntries = juce::ByteOrder::swapIfBigEndian(static_cast<juce::uint32>((binary.getSize() - 12) / 8 - 1));
+    juce::MemoryBlock partial(binary.getData(), 8);
+    partial.append(&numEntries, 4);
+
+    for (size_t offset = 12; offset < binary.getSize(); offset += 8)
+        if (std::memcmp(static_cast<const char*>(binary.getData()) + offset, &omittedHash, 4) != 0)
+            partial.append(static_cast<const char*>(binary.getData()) + offset, 8);
+
+    std::unique_ptr<juce::AudioProcessor> fromPartial(createPluginFilter());
+    setPlainValue(*fromPartial, "gain3", 55.0f);
+    fromPartial->setStateInformation(partial.getData(), static_cast<int>(partial.getSize()));
+
+    auto* reset = findParameter(*fromPartial, "gain3");
+    report.expect(reset->getValue() == reset->getDefaultValue() && omitted->getValue() != reset->getDefaultValue(),
+        "omitted parameter back to default", reset->getValue());
+
+    setPlainValue(*saved, "gain3", omitted->convertFrom0to1(reset->getDefaultValue()));
+    report.expect(compareParameters(*saved, *fromPartial) < 1.0e-6f, "others loaded from partial state",
+        compareParameters(*saved, *fromPartial));
+
+    std::printf("%d state checks failed\n", report.numFailed);
+    return report.numFailed;
+}
+
+//==============================================================================
+// Double precision runs the same DSP, so it only differs from float by
+// float's rounding
+int runDoubleChecks()
+{
+    CheckReport report;
+
+    for (auto isLong : { false, true })
+    {
+        RenderSetup setup;
+        setup.inputChannels = 2;
+        setup.input = noise;
+        setup.numSamples = 96000;
+        setEveryPath(setup);
+        setup.values["longDelay"] = isLong ? 1.0f : 0.0f;
+
+        // A truncating tap swept by its LFO lands on whichever whole sample
+        // each precision rounds to, so the modulated taps interpolate here
+        setup.values["interp1"] = 1.0f;
+        setup.values["interp4"] = 2.0f;
+
+        auto single = render(setup);
+        setup.isDouble = true;
+        auto precise = render(setup);
+
+        auto maxDifference = 0.0;
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < setup.numSamples; ++i)
+                maxDifference = juce::jmax(maxDifference, std::abs(single.getSample(channel, i) - precise.getSample(channel, i)));
+
+        report.expect(maxDifference < 2.0e-4, juce::String(isLong ? "long" : "full") + " float against double", maxDifference);
+    }
+
+    std::printf("%d double checks failed\n", report.numFailed);
+    return report.numFailed;
+}
+
+//==============================================================================
+// Renders one tap that jumps from 250 ms to 117.3 ms half a second in, with
+// the change crossfaded
+static juce::AudioBuffer<double> renderTimeChange(std::function<double(int, int)> input)
+{
+    RenderSetup setup;
+    setup.numSamples = settle_length + 12000;
+    setup.input = std::move(input);
+    setup.values["gain1"] = 100.0f;
+    setup.values["timeMode"] = 1.0f;
+    setup.update = [](juce::AudioProcessor& processor, int position)
+    {
+        setPlainValue(processor, "delay1", position >= settle_length ? 117.3f : 250.0f);
+    };
+
+    return render(setup);
+}
+
+int runCrossfadeChecks()
+{
+    CheckReport report;
+
+    // Both heads read the same constant, so the level must not move
+    auto constant = renderTimeChange(nullptr);
+    auto settled = constant.getSample(0, settle_length - 1);
+    auto maxBump = 0.0;
+
+    for (int i = settle_length; i < constant.getNumSamples(); ++i)
+        maxBump = juce::jmax(maxBump, std::abs(constant.getSample(0, i) / settled - 1.0));
+
+    report.expect(settled > 0.1 && maxBump < 1.0e-4, "constant level through a crossfade", maxBump);
+
+    // A sine steps no further per sample while its two phases fade than it
+    // did before, so the fade is free of clicks
+    auto sine = renderTimeChange([](int, int sample)
+    {
+        return 0.5 * std::sin(2.0 * juce::MathConstants<double>::pi * 200.0 * sample / check_sample_rate);
+    });
+
+    auto getMaxStep = [&sine](int start, int end)
+    {
+        auto maxStep = 0.0;
+
+        for (int i = start; i < end; ++i)
+            maxStep = juce::jmax(maxStep, std::abs(sine.getSample(0, i) - sine.getSample(0, i - 1)));
+
+        return maxStep;
+    };
+
+    auto stepRatio = getMaxStep(settle_length, sine.getNumSamples()) / getMaxStep(settle_length - 4800, settle_length);
+    report.expect(stepRatio < 1.05, "sine steps through a crossfade", stepRatio);
+
+    std::printf("%d crossfade checks failed\n", report.numFailed);
+    return report.numFailed;
+}
+
+//==============================================================================
+// Renders an impulse into the left channel once the tap has settled on
+// 100 ms, and measures how much of each echo's level the next keeps. Echoes are summed
+// over both channels, so crossed feedback counts wherever it lands.
+static double measureLoopGain(float feedback, float cross)
+{
+    static constexpr int echo_length = 4800;
+
+    RenderSetup setup;
+    setup.inputChannels = 2;
+    setup.numSamples = settle_length + echo_length * 6;
+    setup.input = [](int channel, int sample) { return channel == 0 && sample == settle_length ? 1.0 : 0.0; };
+    setup.values["gain1"] = 100.0f;
+    setup.values["delay1"] = 100.0f;
+    setup.values["fdbk1"] = feedback;
+    setup.values["cross"] = cross;
+
+    auto output = render(setup);
+
+    auto getEcho = [&output](int echo)
+    {
+        auto power = 0.0;
+
+        for (int channel = 0; channel < output.getNumChannels(); ++channel)
+            for (int i = settle_length + echo * echo_length - echo_length / 2;
+                 i < settle_length + (echo + 1) * echo_length - echo_length / 2; ++i)
+                power += juce::square(output.getSample(channel, i));
+
+        return std::sqrt(power);
+    };
+
+    return std::pow(getEcho(5) / getEcho(1), 0.25);
+}
+
+int runFeedbackChecks()
+{
+    CheckReport report;
+
+    auto half = measureLoopGain(50.0f, 0.0f);
+    report.expect(std::abs(half - 0.5) < 1.0e-3, "echoes keep half at 50%", half);
+
+    auto crossed = measureLoopGain(50.0f, 100.0f);
+    report.expect(std::abs(crossed - 0.5) < 1.0e-3, "ping-pong echoes keep half at 50%", crossed);
+
+    auto full = measureLoopGain(100.0f, 0.0f);
+    report.expect(std::abs(full - 0.98) < 1.0e-3, "echoes at 100% keep the loop below one", full);
+
+    // Every tap at full feedback, through every path, still dies away
+    RenderSetup setup;
+    setup.inputChannels = 2;
+    setup.numSamples = 6 * static_cast<int>(check_sample_rate);
+    setup.input = [](int channel, int sample) { return sample < 4800 ? noise(channel, sample) : 0.0; };
+    setEveryPath(setup);
+
+    for (int i = 1; i <= num_delays; ++i)
+        setup.values["fdbk" + juce::String(i)] = 100.0f;
+
+    auto output = render(setup);
+
+    auto getLevel = [&output](int second)
+    {
+        auto start = second * static_cast<int>(check_sample_rate);
+        auto level = 0.0;
+
+        for (int channel = 0; channel < output.getNumChannels(); ++channel)
+            level = juce::jmax(level, static_cast<double>(output.getMagnitude(channel, start, static_cast<int>(check_sample_rate))));
+
+        return level;
+    };
+
+    auto decay = getLevel(5) / getLevel(1);
+    report.expect(std::isfinite(decay) && decay < 0.5, "full feedback on every tap decays", decay);
+
+    std::printf("%d feedback checks failed\n", report.numFailed);
+    return report.numFailed;
+}
+
+//==============================================================================
+// Level in dB of a sine at hertz through one tap, filtered as values say,
+// against the same tap unfiltered. Measured over whole periods once the
+// filters have settled.
+static double measureFilterGain(double hertz, const std::map<juce::String, float>& values)
+{
+    auto getLevel = [hertz](const std::map<juce::String, float>& tapValues)
+    {
+        RenderSetup setup;
+        setup.numSamples = settle_length + 4800;
+        setup.values = tapValues;
+        setup.values["gain1"] = 100.0f;
+        setup.input = [hertz](int, int sample)
+        {
+            return 0.5 * std::sin(2.0 * juce::MathConstants<double>::pi * hertz * sample / check_sample_rate);
+        };
+
+        auto output = render(setup);
+        auto power = 0.0;
+
+        for (int i = settle_length; i < setup.numSamples; ++i)
+            power += juce::square(output.getSample(0, i));
+
+        return power;
+    };
+
+    return 10.0 * std::log10(getLevel(values) / getLevel({}));
+}
+
+// Largest second difference of a low sine through one tap after its
+// low-pass cutoff moves, against the largest before. A cutoff that jumps
+// leaves the filter state out of step with its coefficients and clicks.
+static double measureCutoffStep(float fromHertz, float toHertz)
+{
+    RenderSetup setup;
+    setup.numSamples = settle_length * 2;
+    setup.values["gain1"] = 100.0f;
+    setup.values["lpf1"] = fromHertz;
+    setup.input = [](int, int sample)
+    {
+        return 0.5 * std::sin(2.0 * juce::MathConstants<double>::pi * 100.0 * sample / check_sample_rate);
+    };
+    setup.update = [toHertz](juce::AudioProcessor& processor, int position)
+    {
+        if (position >= settle_length)
+            setPlainValue(processor, "lpf1", toHertz);
+    };
+
+    auto output = render(setup);
+
+    auto getLargest = [&output](int start, int end)
+    {
+        auto largest = 0.0;
+
+        for (int i = start; i < end; ++i)
+            largest = juce::jmax(largest, std::abs(output.getSample(0, i) - 2.0 * output.getSample(0, i - 1)
+                + output.getSample(0, i - 2)));
+
+        return largest;
+    };
+
+    return getLargest(settle_length + 2, setup.numSamples) / getLargest(settle_length / 2, settle_length);
+}
+
+int runFilterChecks()
+{
+    CheckReport report;
+
+    auto expectGain = [&report](const juce::String& name, double hertz, const std::map<juce::String, float>& values,
+        double expected, double tolerance)
+    {
+        auto gain = measureFilterGain(hertz, values);
+        report.expect(std::abs(gain - expected) < tolerance, name, gain);
+    };
+
+    // Both stages are Butterworth, 3 dB down at their cutoff and flat two
+    // octaves into their pass band
+    expectGain("low-pass at its cutoff",      1000.0, { { "lpf1", 1000.0f } }, -3.0103, 0.05);
+    expectGain("low-pass in its pass band",    250.0, { { "lpf1", 1000.0f } },  0.0,    0.05);
+    expectGain("low-pass an octave above",    2000.0, { { "lpf1", 1000.0f } }, -12.3,   0.5);
+    expectGain("high-pass at its cutoff",     1000.0, { { "hpf1", 1000.0f } }, -3.0103, 0.05);
+    expectGain("high-pass in its pass band",  4000.0, { { "hpf1", 1000.0f } },  0.0,    0.05);
+    expectGain("high-pass an octave below",    500.0, { { "hpf1", 1000.0f } }, -12.3,   0.5);
+    expectGain("band between both cutoffs",   1000.0, { { "hpf1", 100.0f }, { "lpf1", 10000.0f } }, 0.0, 0.05);
+
+    // The cutoff ramps rather than jumping at a block, which measures in the
+    // hundreds. The sweep itself bends the sine a little.
+    auto step = measureCutoffStep(200.0f, 8000.0f);
+    report.expect(step < 10.0, "cutoff change ramps without a click", step);
+
+    std::printf("%d filter checks failed\n", report.numFailed);
+    return report.numFailed;
+}
+
+//==============================================================================
+// Delay in samples of one linearly interpolated tap, hard left, at every
+// sample past settle_length. The input is a ramp rising one per sample, so
+// the output falls behind it by exactly the delay read.
+static std::vector<double> measureSweep(float rateHertz, float depthMs, int numSamples)
+{
+    RenderSetup setup;
+    setup.isDouble = true;
+    setup.numSamples = settle_length + numSamples;
+    setup.input = [](int, int sample) { return static_cast<double>(sample); };
+    setup.values["gain1"] = 100.0f;
+    setup.values["pan1"] = 0.0f;
+    setup.values["interp1"] = 1.0f;
+    setup.values["rate1"] = rateHertz;
+    setup.values["depth1"] = depthMs;
+
+    auto output = render(setup);
+    std::vector<double> delays;
+
+    for (int i = settle_length; i < setup.numSamples; ++i)
+        delays.push_back(static_cast<double>(i) - output.getSample(0, i));
+
+    return delays;
+}
+
+int runLfoChecks()
+{
+    CheckReport report;
+
+    // Two seconds at 2.5 Hz sweep 5 ms past the 250 ms delay five times,
+    // starting a quarter cycle from the middle so no crossing sits on an end
+    auto delays = measureSweep(2.5f, 5.0f, 96000);
+    auto shortest = *std::min_element(delays.begin(), delays.end());
+    auto longest = *std::max_element(delays.begin(), delays.end());
+
+    report.expect(std::abs(shortest - 12000.0) < 0.05, "sweep starts at the delay", shortest);
+    report.expect(std::abs(longest - shortest - 240.0) < 0.05, "sweep spans the depth", longest - shortest);
+
+    auto middle = (shortest + longest) / 2;
+    auto numCrossings = 0;
+
+    for (size_t i = 1; i < delays.size(); ++i)
+        numCrossings += (delays[i - 1] < middle) != (delays[i] < middle) ? 1 : 0;
+
+    report.expect(numCrossings == 10, "sweep runs at the rate", numCrossings);
+
+    // No depth leaves the delay alone
+    auto still = measureSweep(2.0f, 0.0f, 4800);
+    auto maxMove = 0.0;
+
+    for (auto delay : still)
+        maxMove = juce::jmax(maxMove, std::abs(delay - 12000.0));
+
+    report.expect(maxMove == 0.0, "no depth, no sweep", maxMove);
+
+    std::printf("%d LFO checks failed\n", report.numFailed);
+    return report.numFailed;
+}
+
+//==============================================================================
+// Renders noise at level, from settle_length on, through one hard left tap
+// 14400 samples long, stored compactly or in full
+static juce::AudioBuffer<double> renderStored(bool isCompact, double level, float feedback)
+{
+    RenderSetup setup;
+    setup.numSamples = settle_length + 3 * static_cast<int>(check_sample_rate);
+    setup.input = [level](int channel, int sample) { return sample >= settle_length ? level * noise(channel, sample) : 0.0; };
+    setup.values["gain1"] = 100.0f;
+    setup.values["pan1"] = 0.0f;
+    setup.values["fdbk1"] = feedback;
+    setup.values["longDelay"] = isCompact ? 1.0f : 0.0f;
+    setup.values["delay1"] = isCompact ? 300.0f / SequencedDelay::long_delay_time_scale : 300.0f;
+
+    return render(setup);
+}
+
+// Largest difference between compact and full renders, in mantissa steps
+// of the loudest sample stored, which the tap reads back at unity gain
+static double measureCompactError(double level, float feedback)
+{
+    auto compact = renderStored(true, level, feedback);
+    auto full = renderStored(false, level, feedback);
+    auto maxError = 0.0;
+
+    for (int i = 0; i < full.getNumSamples(); ++i)
+        maxError = juce::jmax(maxError, std::abs(compact.getSample(0, i) - full.getSample(0, i)));
+
+    return maxError / (full.getMagnitude(0, 0, full.getNumSamples()) / 32767.0);
+}
+
+int runCompactChecks()
+{
+    CheckReport report;
+
+    // A line read once is off by no more than the rounding of a mantissa,
+    // whatever the level, as every block keeps its own scale
+    auto loud = measureCompactError(1.0, 0.0f);
+    report.expect(loud <= 0.51, "loud line within half a step", loud);
+
+    auto quiet = measureCompactError(0.001, 0.0f);
+    report.expect(quiet <= 0.51, "quiet line within half a step", quiet);
+
+    // Each pass through the loop rounds again, but the loop gain shrinks
+    // the errors already made, so they add up to no more than 1 / (1 - 0.9)
+    auto fedBack = measureCompactError(1.0, 90.0f);
+    report.expect(fedBack <= 5.1, "90% feedback within five steps", fedBack);
+
+    std::printf("%d compact checks failed\n", report.numFailed);
+    return report.numFailed;
+}
+
+//==============================================================================
+int runBehaviourChecks(const juce::String& name)
+{
+    if (name == "panner")    return runPannerChecks();
+    if (name == "offline")   return runOfflineChecks();
+    if (name == "state")     return runStateChecks();
+    if (name == "double")    return runDoubleChecks();
+    if (name == "crossfade") return runCrossfadeChecks();
+    if (name == "feedback")  return runFeedbackChecks();
+    if (name == "filter")    return runFilterChecks();
+    if (name == "lfo")       return runLfoChecks();
+    if (name == "compact")   return runCompactChecks();
+
+    std::printf("unknown check %s\n", name.toRawUTF8());
+    return 1;
+}
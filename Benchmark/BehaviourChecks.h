@@ -0,0 +1,52 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Behaviour checks the golden renders do not cover, one group per --check
+// name. Every check prints one line and fails the group if it is off.
+
+// Runs the group called name
+// @return - Number of failed checks
+int runBehaviourChecks(const juce::String& name);
+
+// Surround panning and the dry routing of a mono input
+// @return - Number of failed checks
+int runPannerChecks();
+
+// Offline renders match realtime ones sample for sample, with every DSP
+// path on. The golden renders check the same for their stereo cases
+// @return - Number of failed checks
+int runOfflineChecks();
+
+// Binary state round trips, XML states from earlier versions load, and
+// truncated or newer binary states are rejected
+// @return - Number of failed checks
+int runStateChecks();
+
+// Float and double renders agree to within float rounding, with the line
+// stored in full and compactly
+// @return - Number of failed checks
+int runDoubleChecks();
+
+// Crossfaded time changes keep a constant level and do not click
+// @return - Number of failed checks
+int runCrossfadeChecks();
+
+// Feedback keeps its set share of each echo, crossed or not, and the loop
+// stays stable with every tap at full feedback
+// @return - Number of failed checks
+int runFeedbackChecks();
+
+// Tap filters cut by the right amount at and around their cutoffs
+// @return - Number of failed checks
+int runFilterChecks();
+
+// Delay LFOs sweep their tap by the set depth at the set rate
+// @return - Number of failed checks
+int runLfoChecks();
+
+// A compactly stored line stays within its rounding of the full one, with
+// and without feedback
+// @return - Number of failed checks
+int runCompactChecks();
@@ -0,0 +1,576 @@
+#include "GoldenRender.h"
+#include "PluginProcessor.h"
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+//==============================================================================
+// The original SequencedDelay algorithm, kept verbatim as the reference for
+// every optimized path: modulo ring buffer, per-sample juce::SmoothedValue
+// calls and a per-sample dry/wet loop.
+class ScalarReference
+{
+public:
+    //==========================================================================
+    struct Tap
+    {
+        float delay, gain, pan, sixt;
+        bool sync;
+    };
+
+    void prepare(double newSampleRate, int numChannels)
+    {
+        sampleRate = newSampleRate;
+
+        for (int i = 0; i < num_delays; ++i)
+        {
+            delaySamples[i].reset(sampleRate, 0.2f);
+            gainL[i].reset(sampleRate, 0.02f);
+            gainR[i].reset(sampleRate, 0.02f);
+        }
+        blendSmooth.reset(sampleRate, 0.02f);
+
+        delayBuffer.setSize(numChannels, static_cast<int>(sampleRate * 5.0f));
+        delayBuffer.clear();
+        writePosition = 0;
+    }
+
+    void process(juce::AudioBuffer<float>& buffer, int inputChannels, const Tap* taps, float blend, double bpm)
+    {
+        auto outputChannels = delayBuffer.getNumChannels();
+        auto bufferSize = buffer.getNumSamples();
+        auto delayBufferSize = delayBuffer.getNumSamples();
+
+        for (int channel = inputChannels; channel < outputChannels; ++channel)
+        {
+            buffer.clear(channel, 0, bufferSize);
+            buffer.copyFrom(channel, 0, buffer.getReadPointer(channel % inputChannels, 0), bufferSize);
+        }
+
+        wetBuffer.setSize(outputChannels, bufferSize);
+        wetBuffer.clear();
+
+        for (int channel = 0; channel < outputChannels; ++channel)
+        {
+            auto* channelData = buffer.getReadPointer(channel);
+
+            if (delayBufferSize > bufferSize + writePosition)
+            {
+                delayBuffer.copyFrom(channel, writePosition, channelData, bufferSize);
+            }
+            else
+            {
+                int numSamplesToEnd = delayBufferSize - writePosition;
+                delayBuffer.copyFrom(channel, writePosition, channelData, numSamplesToEnd);
+                delayBuffer.copyFrom(channel, 0, channelData + numSamplesToEnd, bufferSize - numSamplesToEnd);
+            }
+        }
+
+        for (int i = 0; i < num_delays; ++i)
+        {
+            auto& tap = taps[i];
+
+            if (!tap.sync)
+                delaySamples[i].setTargetValue(static_cast<int>(sampleRate * (tap.delay / 1000.0f)));
+            else
+                delaySamples[i].setTargetValue(static_cast<int>(sampleRate * ((60.0f / bpm) * (tap.sixt / 4.0f))));
+
+            auto thisPan = tap.pan / 100.0f;
+            auto thisGain = tap.gain / 100.0f;
+            gainL[i].setTargetValue(sin(0.5f * referencePi * (1.0f - thisPan)) * thisGain);
+            gainR[i].setTargetValue(sin(0.5f * referencePi * thisPan) * thisGain);
+
+            for (int sample = 0; sample < bufferSize; ++sample)
+            {
+                int pos = (writePosition + sample - delaySamples[i].getNextValue()
+                    + delayBufferSize) % delayBufferSize;
+
+                for (int channel = 0; channel < outputChannels; ++channel)
+                {
+                    *wetBuffer.getWritePointer(channel, sample) += *delayBuffer.getReadPointer(channel, pos)
+                        * (channel == 0 ? gainL[i].getNextValue() : gainR[i].getNextValue());
+                }
+            }
+        }
+
+        writePosition += bufferSize;
+        writePosition %= delayBufferSize;
+
+        blendSmooth.setTargetValue(blend);
+
+        for (int sample = 0; sample < bufferSize; ++sample)
+        {
+            auto wetGain = blendSmooth.getNextValue() / 100.0f;
+
+            for (int channel = 0; channel < outputChannels; ++channel)
+            {
+                auto* dryData = buffer.getWritePointer(channel, sample);
+                *dryData *= 1.0f - wetGain;
+                *dryData += *wetBuffer.getReadPointer(channel, sample) * wetGain;
+            }
+        }
+    }
+
+private:
+    //==========================================================================
+    const float referencePi = 2 * std::acos(0.0);
+
+    double sampleRate{ 0.0 };
+
+    juce::AudioBuffer<float> delayBuffer;
+    juce::AudioBuffer<float> wetBuffer;
+    int writePosition{ 0 };
+
+    juce::SmoothedValue<int> delaySamples [num_delays];
+    juce::SmoothedValue<float> gainL [num_delays];
+    juce::SmoothedValue<float> gainR [num_delays];
+    juce::SmoothedValue<float> blendSmooth;
+};
+
+//==============================================================================
+class GoldenPlayHead : public juce::AudioPlayHead
+{
+public:
+    double bpm{ 120.0 };
+
+   #if JUCE_MAJOR_VERSION >= 7
+    juce::Optional<PositionInfo> getPosition() const override
+    {
+        PositionInfo info;
+        info.setBpm(bpm);
+        info.setIsPlaying(true);
+        return info;
+    }
+   #else
+    bool getCurrentPosition(CurrentPositionInfo& result) override
+    {
+        result.resetToDefault();
+        result.bpm = bpm;
+        result.isPlaying = true;
+        return true;
+    }
+   #endif
+};
+
+//==============================================================================
+// Parameter values a case wants for the next block, by parameter ID
+struct CaseState
+{
+    std::map<juce::String, float> values;
+    double bpm{ 120.0 };
+
+    void set(const juce::String& id, float value) { values[id] = value; }
+    void setTap(int tap, const juce::String& name, float value) { set(name + juce::String(tap + 1), value); }
+};
+
+struct GoldenCase
+{
+    juce::String name;
+    double sampleRate;
+    int preparedBlockSize;
+    std::vector<int> blockSizes;
+    bool monoInput;
+    double seconds;
+    std::function<void(int block, CaseState&)> update;
+};
+
+//==============================================================================
+static std::vector<GoldenCase> createCases()
+{
+    std::vector<GoldenCase> cases;
+
+    auto spread = [](int numTaps)
+    {
+        return [numTaps](int block, CaseState& s)
+        {
+            if (block != 0)
+                return;
+
+            for (int i = 0; i < numTaps; ++i)
+            {
+                s.setTap(i, "delay", 13.7f + 241.3f * static_cast<float>(i));
+                s.setTap(i, "gain", 20.0f + 5.0f * static_cast<float>(i));
+                s.setTap(i, "pan", static_cast<float>((i * 29) % 101));
+            }
+            s.set("blend", 60.0f);
+        };
+    };
+
+    for (auto rate : { 44100.0, 48000.0, 96000.0 })
+        for (auto mono : { false, true })
+            cases.push_back({ "free-16taps", rate, 512, { 512 }, mono, 4.5, spread(16) });
+
+    cases.push_back({ "free-1tap", 44100.0, 256, { 256 }, false, 2.0, spread(1) });
+    cases.push_back({ "free-4taps-odd-blocks", 44100.0, 4096, { 1, 17, 333, 4096, 64, 2 }, false, 3.0, spread(4) });
+    cases.push_back({ "free-4taps-oversized-blocks", 48000.0, 64, { 256, 1000, 64, 3 }, false, 3.0, spread(4) });
+
+    // Sync on with every sixteenth from 1 to 16
+    for (auto mono : { false, true })
+        cases.push_back({ "sync-sixteenths", 44100.0, 512, { 512 }, mono, 5.0, [](int block, CaseState& s)
+        {
+            if (block != 0)
+                return;
+
+            for (int i = 0; i < num_delays; ++i)
+            {
+                s.setTap(i, "sync", 1.0f);
+                s.setTap(i, "sixt", static_cast<float>(i % 16 + 1));
+                s.setTap(i, "gain", 30.0f);
+                s.setTap(i, "pan", static_cast<float>((i * 6) % 101));
+            }
+            s.set("blend", 100.0f);
+        } });
+
+    // Host tempo changes under synced taps
+    cases.push_back({ "sync-bpm-changes", 48000.0, 480, { 480 }, false, 6.0, [](int block, CaseState& s)
+    {
+        if (block == 0)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                s.setTap(i, "sync", 1.0f);
+                s.setTap(i, "sixt", static_cast<float>(1 + i * 3));
+                s.setTap(i, "gain", 60.0f);
+            }
+        }
+
+        if (block == 100) s.bpm = 97.0;
+        if (block == 250) s.bpm = 180.0;
+        if (block == 400) s.bpm = 63.5;
+    } });
+
+    // Hard-panned taps
+    cases.push_back({ "pan-extremes", 44100.0, 128, { 128 }, false, 2.0, [](int block, CaseState& s)
+    {
+        if (block != 0)
+            return;
+
+        s.setTap(0, "gain", 100.0f); s.setTap(0, "pan", 0.0f); s.setTap(0, "delay", 100.0f);
+        s.setTap(1, "gain", 100.0f); s.setTap(1, "pan", 100.0f); s.setTap(1, "delay", 150.0f);
+        s.setTap(2, "gain", 100.0f); s.setTap(2, "pan", 50.0f); s.setTap(2, "delay", 0.0f);
+    } });
+
+    // Continuous automation of every control, including blend
+    for (auto mono : { false, true })
+        cases.push_back({ "automation", 44100.0, 256, { 256, 31, 512 }, mono, 6.0, [](int block, CaseState& s)
+        {
+            auto phase = static_cast<float>(block) * 0.05f;
+
+            for (int i = 0; i < 8; ++i)
+            {
+                auto lfo = 0.5f + 0.5f * std::sin(phase + static_cast<float>(i));
+                s.setTap(i, "delay", 5.0f + 300.0f * static_cast<float>(i) + 200.0f * lfo);
+                s.setTap(i, "gain", (block / 40 + i) % 3 == 0 ? 0.0f : 100.0f * lfo);
+                s.setTap(i, "pan", 100.0f * (1.0f - lfo));
+                s.setTap(i, "sync", (block / 60 + i) % 4 == 0 ? 1.0f : 0.0f);
+                s.setTap(i, "sixt", static_cast<float>(1 + (block / 30 + i) % 16));
+            }
+
+            s.set("blend", block % 90 < 45 ? 100.0f : 25.0f);
+            s.bpm = block < 300 ? 120.0 : 141.0;
+        } });
+
+    return cases;
+}
+
+//==============================================================================
+static juce::RangedAudioParameter* findParameter(juce::AudioProcessor& processor, const juce::String& id)
+{
+    for (auto* param : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+            if (ranged->paramID == id)
+                return ranged;
+
+    return nullptr;
+}
+
+// Reads the plain value the processor sees, without a normalised round trip
+static float getPlainValue(juce::RangedAudioParameter* param)
+{
+    if (auto* p = dynamic_cast<juce::AudioParameterFloat*>(param))
+        return p->get();
+
+    if (auto* p = dynamic_cast<juce::AudioParameterInt*>(param))
+        return static_cast<float>(p->get());
+
+    if (auto* p = dynamic_cast<juce::AudioParameterBool*>(param))
+        return p->get() ? 1.0f : 0.0f;
+
+    return param->convertFrom0to1(param->getValue());
+}
+
+static juce::uint64 hashSamples(juce::uint64 hash, const float* data, int numSamples)
+{
+    // FNV-1a over the raw sample bits
+    auto* bytes = reinterpret_cast<const juce::uint8*>(data);
+
+    for (size_t i = 0; i < sizeof(float) * static_cast<size_t>(numSamples); ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+//==============================================================================
+struct CaseResult
+{
+    float maxDifference{ 0.0f };
+    juce::uint64 processorHash{ 0xcbf29ce484222325ULL };
+    juce::uint64 referenceHash{ 0xcbf29ce484222325ULL };
+    juce::Array<float> envelope[2];
+};
+
+static constexpr int envelope_window = 4096;
+
+// Offline, the delay line grows in processBlock. In realtime it grows in the
+// background and taps are clamped until it has, so the line is sized up
+// front for the longest Delay Time instead; prepareToPlay sizes it from the
+// parameters, which are put back afterwards.
+static CaseResult renderCase(const GoldenCase& c, bool isRealtime)
+{
+    CaseResult result;
+
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+    GoldenPlayHead playHead;
+    auto inputChannels = c.monoInput ? 1 : 2;
+
+    processor->setNonRealtime(!isRealtime);
+    processor->setPlayHead(&playHead);
+    processor->setPlayConfigDetails(inputChannels, 2, c.sampleRate, c.preparedBlockSize);
+
+    std::vector<std::pair<juce::RangedAudioParameter*, float>> presized;
+
+    if (isRealtime)
+    {
+        for (int i = 0; i < num_delays; ++i)
+        {
+            if (auto* param = findParameter(*processor, "delay" + juce::String(i + 1)))
+            {
+                presized.emplace_back(param, param->getValue());
+                param->setValueNotifyingHost(1.0f);
+            }
+        }
+    }
+
+    processor->prepareToPlay(c.sampleRate, c.preparedBlockSize);
+
+    for (auto& param : presized)
+        param.first->setValueNotifyingHost(param.second);
+
+    ScalarReference reference;
+    reference.prepare(c.sampleRate, 2);
+
+    juce::RangedAudioParameter* params[num_delays][5];
+    const char* tapParamNames[5] = { "delay", "gain", "pan", "sync", "sixt" };
+
+    for (int i = 0; i < num_delays; ++i)
+        for (int p = 0; p < 5; ++p)
+            params[i][p] = findParameter(*processor, tapParamNames[p] + juce::String(i + 1));
+
+    auto* blendParam = findParameter(*processor, "blend");
+
+    juce::Random random(0x601d);
+    CaseState state;
+    juce::MidiBuffer midi;
+
+    auto totalSamples = static_cast<int>(c.seconds * c.sampleRate);
+    auto maxBlock = *std::max_element(c.blockSizes.begin(), c.blockSizes.end());
+    juce::AudioBuffer<float> buffer(2, maxBlock), expected(2, maxBlock);
+
+    double envelopeSum[2] = { 0.0, 0.0 };
+    int envelopeCount = 0;
+
+    for (int block = 0, position = 0; position < totalSamples; ++block)
+    {
+        auto numSamples = juce::jmin(c.blockSizes[static_cast<size_t>(block) % c.blockSizes.size()], totalSamples - position);
+
+        c.update(block, state);
+        playHead.bpm = state.bpm;
+
+        for (auto& value : state.values)
+            if (auto* param = findParameter(*processor, value.first))
+                if (getPlainValue(param) != value.second)
+                    param->setValueNotifyingHost(param->convertTo0to1(value.second));
+
+        ScalarReference::Tap taps[num_delays];
+
+        for (int i = 0; i < num_delays; ++i)
+        {
+            taps[i].delay = getPlainValue(params[i][0]);
+            taps[i].gain = getPlainValue(params[i][1]);
+            taps[i].pan = getPlainValue(params[i][2]);
+            taps[i].sync = getPlainValue(params[i][3]) != 0.0f;
+            taps[i].sixt = getPlainValue(params[i][4]);
+        }
+
+        // Noise bursts, a sine and stretches of silence so tails get tested
+        buffer.setSize(2, numSamples, false, false, true);
+        expected.setSize(2, numSamples, false, false, true);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto t = static_cast<double>(position + i) / c.sampleRate;
+            auto isSilent = std::fmod(t, 1.5) > 1.0;
+            auto sine = static_cast<float>(0.3 * std::sin(juce::MathConstants<double>::twoPi * 220.0 * t));
+
+            buffer.setSample(0, i, isSilent ? 0.0f : sine + 0.5f * (random.nextFloat() - 0.5f));
+            buffer.setSample(1, i, c.monoInput ? 0.0f : (isSilent ? 0.0f : 0.8f * (random.nextFloat() - 0.5f)));
+        }
+
+        for (int channel = 0; channel < 2; ++channel)
+            expected.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+
+        processor->processBlock(buffer, midi);
+        reference.process(expected, inputChannels, taps, getPlainValue(blendParam), state.bpm);
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto* out = buffer.getReadPointer(channel);
+            auto* ref = expected.getReadPointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                result.maxDifference = juce::jmax(result.maxDifference, std::abs(out[i] - ref[i]));
+
+            result.processorHash = hashSamples(result.processorHash, out, numSamples);
+            result.referenceHash = hashSamples(result.referenceHash, ref, numSamples);
+        }
+
+        // RMS envelope of the reference for the golden file
+        for (int i = 0; i < numSamples; ++i)
+        {
+            for (int channel = 0; channel < 2; ++channel)
+                envelopeSum[channel] += juce::square(static_cast<double>(expected.getSample(channel, i)));
+
+            if (++envelopeCount == envelope_window)
+            {
+                for (int channel = 0; channel < 2; ++channel)
+                {
+                    result.envelope[channel].add(static_cast<float>(std::sqrt(envelopeSum[channel] / envelope_window)));
+                    envelopeSum[channel] = 0.0;
+                }
+                envelopeCount = 0;
+            }
+        }
+
+        position += numSamples;
+    }
+
+    processor->releaseResources();
+    return result;
+}
+
+//==============================================================================
+static juce::String getCaseId(const GoldenCase& c)
+{
+    return c.name + "@" + juce::String(static_cast<int>(c.sampleRate)) + (c.monoInput ? "-mono" : "-stereo");
+}
+
+static juce::String toHex(juce::uint64 hash)
+{
+    return juce::String::toHexString(static_cast<juce::int64>(hash)).paddedLeft('0', 16);
+}
+
+int runGoldenRenders(const GoldenOptions& options)
+{
+    int numFailed = 0;
+    auto cases = createCases();
+
+    juce::var golden;
+    if (options.checkFile != juce::File())
+        golden = juce::JSON::parse(options.checkFile);
+
+    juce::Array<juce::var> written;
+
+    for (auto& c : cases)
+    {
+        auto id = getCaseId(c);
+        auto result = renderCase(c, false);
+        auto realtimeResult = renderCase(c, true);
+
+        auto passed = options.bitExact ? result.processorHash == result.referenceHash
+                                       : result.maxDifference <= options.tolerance;
+        juce::String note;
+
+        // Realtime renders in smaller pieces across channel groups, which
+        // must not change a sample
+        if (realtimeResult.processorHash != result.processorHash)
+        {
+            passed = false;
+            note = " (realtime differs, max diff " + juce::String(realtimeResult.maxDifference, 3) + ")";
+        }
+
+        // The stored reference must still match, bit for bit or by envelope
+        if (auto* stored = golden.getProperty(id, {}).getDynamicObject())
+        {
+            auto storedHash = stored->getProperty("hash").toString();
+
+            if (options.bitExact && storedHash != toHex(result.processorHash))
+            {
+                passed = false;
+                note = " (golden hash mismatch)";
+            }
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                auto* storedEnvelope = stored->getProperty("envelope").getArray();
+                auto* values = storedEnvelope != nullptr ? storedEnvelope->getReference(channel).getArray() : nullptr;
+
+                if (values == nullptr || values->size() != result.envelope[channel].size())
+                {
+                    passed = false;
+                    note = " (golden envelope missing)";
+                    continue;
+                }
+
+                for (int i = 0; i < values->size(); ++i)
+                {
+                    if (std::abs(static_cast<float>((*values)[i]) - result.envelope[channel][i]) > options.tolerance)
+                    {
+                        passed = false;
+                        note = " (golden envelope drift)";
+                        break;
+                    }
+                }
+            }
+        }
+        else if (options.checkFile != juce::File())
+        {
+            passed = false;
+            note = " (not in golden file)";
+        }
+
+        std::printf("%-4s %-40s max diff %.3g%s\n", passed ? "ok" : "FAIL", id.toRawUTF8(),
+            static_cast<double>(result.maxDifference), note.toRawUTF8());
+
+        if (!passed)
+            ++numFailed;
+
+        juce::Array<juce::var> envelope;
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            juce::Array<juce::var> values;
+            for (auto v : result.envelope[channel])
+                values.add(v);
+            envelope.add(values);
+        }
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("hash", toHex(result.referenceHash));
+        entry->setProperty("envelope", envelope);
+        written.add(juce::var(entry));
+    }
+
+    if (options.writeFile != juce::File())
+    {
+        auto* root = new juce::DynamicObject();
+
+        for (size_t i = 0; i < cases.size(); ++i)
+            root->setProperty(getCaseId(cases[i]), written[static_cast<int>(i)]);
+
+        options.writeFile.replaceWithText(juce::JSON::toString(juce::var(root)));
+    }
+
+    std::printf("%d of %d golden cases failed\n", numFailed, static_cast<int>(cases.size()));
+    return numFailed;
+}
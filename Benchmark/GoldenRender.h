@@ -0,0 +1,27 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Golden-render validation. Every case renders fixed input through the
+// processor and through ScalarReference, a copy of the original per-sample
+// algorithm, and compares the two. The processor renders each case offline
+// and in realtime, which must match to the sample. A compact golden file (an output hash and
+// an RMS envelope per case) can be written and checked later to catch drift
+// between builds.
+struct GoldenOptions
+{
+    // Maximum absolute difference allowed against the scalar reference
+    float tolerance = 1.0e-5f;
+
+    // Require identical output, only meaningful without fast-math/FMA flags.
+    // The interpolated pan-law table differs from sin() by up to ~1e-7, so
+    // any case with a tap that is not hard panned fails this
+    bool bitExact = false;
+
+    juce::File writeFile;
+    juce::File checkFile;
+};
+
+// @return - Number of failed cases
+int runGoldenRenders(const GoldenOptions& options);
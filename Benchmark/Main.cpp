@@ -0,0 +1,482 @@
+#include <JuceHeader.h>
+#include "BehaviourChecks.h"
+#include "GoldenRender.h"
+#include "PluginProcessor.h"
+
+//==============================================================================
+// Headless benchmark for SequencedDelay::processBlock. Renders white noise
+// through a fresh processor for every combination of sample rate, block size,
+// number of active taps and automation mode, then reports the cost per sample
+// and the callback time percentiles. --json writes the same numbers in a
+// machine-readable form for tracking regressions.
+//
+// Options:
+//   --seconds N        Seconds of audio rendered per run (default 120)
+//   --rates a,b,...    Sample rates (default 44100,48000,96000,192000)
+//   --blocks a,b,...   Block sizes (default 16,32,64,128,256,512,1024,2048,4096)
+//   --taps a,b,...     Active tap counts (default 1,4,16, capped at num_delays)
+//   --channels N       Input and output channels, e.g. 12 for 7.1.4 (default 2)
+//   --double           Process in double precision
+//   --offline          Render as a non-realtime bounce
+//   --crossfade        Change delay times with the crossfading read heads
+//   --feedback X       Feedback percentage of every active tap (default 0)
+//   --filter           Band-limit every active tap to 200 Hz - 2 kHz
+//   --lfo              Swing the delay and pan of every active tap
+//   --interp K         Tap interpolation: none, linear, cubic or allpass
+//                      (default none)
+//   --long             Long delay mode, with the delay line stored compactly
+//   --json FILE        Write the results as JSON
+//
+// State save/load timing instead of processing:
+//   --state N          Time N saves and loads of the binary and legacy XML state
+//
+// Golden-render validation instead of timing:
+//   --golden           Compare every golden case against the scalar reference
+//   --tolerance X      Maximum absolute difference allowed (default 1e-5)
+//   --bit-exact        Require identical output instead of a tolerance
+//   --golden-write F   Store hashes and RMS envelopes of the reference
+//   --golden-check F   Also compare against a stored golden file
+//
+// Behaviour checks instead of timing:
+//   --check panner     Surround pan gains and mono dry routing
+//   --check offline    Offline renders against realtime ones, sample for sample
+//   --check state      Binary and XML state loading
+//   --check double     Double precision against float
+//   --check crossfade  Crossfaded delay time changes
+//   --check feedback   Loop gain and stability of the feedback network
+//   --check filter     Tap filter response around the cutoffs
+//   --check lfo        Delay LFO depth and rate
+//   --check compact    Rounding error of compact line storage
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+//==============================================================================
+class BenchmarkPlayHead : public juce::AudioPlayHead
+{
+public:
+   #if JUCE_MAJOR_VERSION >= 7
+    juce::Optional<PositionInfo> getPosition() const override
+    {
+        PositionInfo info;
+        info.setBpm(120.0);
+        info.setIsPlaying(true);
+        return info;
+    }
+   #else
+    bool getCurrentPosition(CurrentPositionInfo& result) override
+    {
+        result.resetToDefault();
+        result.bpm = 120.0;
+        result.isPlaying = true;
+        return true;
+    }
+   #endif
+};
+
+//==============================================================================
+struct RunConfig
+{
+    double sampleRate;
+    int blockSize;
+    int activeTaps;
+    bool automated;
+    int numChannels;
+    bool doublePrecision;
+    bool offline;
+    bool crossfade;
+    float feedback;
+    bool filtered;
+    bool modulated;
+    int interpolation;
+    bool longDelay;
+};
+
+static const juce::StringArray interpolationNames{ "none", "linear", "cubic", "allpass" };
+
+struct RunResult
+{
+    RunConfig config;
+    juce::int64 numSamples;
+    double nsPerSample;
+    double realtimeFactor;
+    double p50, p90, p99, p999, max;
+};
+
+//==============================================================================
+static juce::Array<int> parseList(const juce::String& text)
+{
+    juce::Array<int> values;
+
+    for (auto& token : juce::StringArray::fromTokens(text, ",", ""))
+        if (token.trim().isNotEmpty())
+            values.add(token.trim().getIntValue());
+
+    return values;
+}
+
+static juce::String getOption(const juce::StringArray& args, const juce::String& name, const juce::String& fallback)
+{
+    auto index = args.indexOf(name);
+    return (index >= 0 && index + 1 < args.size()) ? args[index + 1] : fallback;
+}
+
+static juce::RangedAudioParameter* findParameter(juce::AudioProcessor& processor, const juce::String& id)
+{
+    for (auto* param : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+            if (ranged->paramID == id)
+                return ranged;
+
+    jassertfalse;
+    return nullptr;
+}
+
+static void setParameter(juce::RangedAudioParameter* param, float value)
+{
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+static double percentile(const std::vector<double>& sorted, double fraction)
+{
+    auto index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+//==============================================================================
+// Times one processBlock call on the next piece of looped noise
+template <typename SampleType>
+static juce::int64 processNoise(juce::AudioProcessor& processor, juce::AudioBuffer<SampleType>& buffer,
+    const juce::AudioBuffer<float>& noise, int noisePosition)
+{
+    juce::MidiBuffer midi;
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        auto* source = noise.getReadPointer(channel % noise.getNumChannels(), noisePosition);
+        auto* dest = buffer.getWritePointer(channel);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            dest[i] = static_cast<SampleType>(source[i]);
+    }
+
+    auto start = juce::Time::getHighResolutionTicks();
+    processor.processBlock(buffer, midi);
+    return juce::Time::getHighResolutionTicks() - start;
+}
+
+static RunResult run(const RunConfig& config, double seconds, const juce::AudioBuffer<float>& noise)
+{
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+    BenchmarkPlayHead playHead;
+
+    processor->setPlayHead(&playHead);
+    processor->setNonRealtime(config.offline);
+    processor->setPlayConfigDetails(config.numChannels, config.numChannels, config.sampleRate, config.blockSize);
+    processor->setProcessingPrecision(config.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                             : juce::AudioProcessor::singlePrecision);
+
+    // Set first so the line is prepared in its storage
+    setParameter(findParameter(*processor, "longDelay"), config.longDelay ? 1.0f : 0.0f);
+    processor->prepareToPlay(config.sampleRate, config.blockSize);
+
+    // Spread the active taps over the delay range, the rest stay silent
+    juce::RangedAudioParameter* delayParams[num_delays];
+    juce::RangedAudioParameter* gainParams[num_delays];
+    juce::RangedAudioParameter* panParams[num_delays];
+    juce::RangedAudioParameter* feedbackParams[num_delays];
+    juce::RangedAudioParameter* lowPassParams[num_delays];
+    juce::RangedAudioParameter* highPassParams[num_delays];
+    juce::RangedAudioParameter* rateParams[num_delays];
+    juce::RangedAudioParameter* depthParams[num_delays];
+    juce::RangedAudioParameter* panDepthParams[num_delays];
+    juce::RangedAudioParameter* interpolationParams[num_delays];
+
+    for (int i = 0; i < num_delays; ++i)
+    {
+        auto numStr = juce::String(i + 1);
+        delayParams[i] = findParameter(*processor, "delay" + numStr);
+        gainParams[i] = findParameter(*processor, "gain" + numStr);
+        panParams[i] = findParameter(*processor, "pan" + numStr);
+        feedbackParams[i] = findParameter(*processor, "fdbk" + numStr);
+        lowPassParams[i] = findParameter(*processor, "lpf" + numStr);
+        highPassParams[i] = findParameter(*processor, "hpf" + numStr);
+        rateParams[i] = findParameter(*processor, "rate" + numStr);
+        depthParams[i] = findParameter(*processor, "depth" + numStr);
+        panDepthParams[i] = findParameter(*processor, "panMod" + numStr);
+        interpolationParams[i] = findParameter(*processor, "interp" + numStr);
+
+        bool isActive = i < config.activeTaps;
+        setParameter(delayParams[i], 40.0f + 230.0f * static_cast<float>(i % 17));
+        setParameter(gainParams[i], isActive ? 70.0f : 0.0f);
+        setParameter(panParams[i], isActive ? static_cast<float>((i * 37) % 101) : 50.0f);
+        setParameter(feedbackParams[i], isActive ? config.feedback : 0.0f);
+        setParameter(lowPassParams[i], isActive && config.filtered ? 2000.0f : 20000.0f);
+        setParameter(highPassParams[i], isActive && config.filtered ? 200.0f : 20.0f);
+        setParameter(rateParams[i], 0.5f + 0.1f * static_cast<float>(i));
+        setParameter(depthParams[i], isActive && config.modulated ? 5.0f : 0.0f);
+        setParameter(panDepthParams[i], isActive && config.modulated ? 50.0f : 0.0f);
+        setParameter(interpolationParams[i], static_cast<float>(config.interpolation));
+    }
+
+    setParameter(findParameter(*processor, "blend"), 50.0f);
+    setParameter(findParameter(*processor, "timeMode"), config.crossfade ? 1.0f : 0.0f);
+
+    juce::AudioBuffer<float> floatBuffer(config.doublePrecision ? 0 : config.numChannels, config.blockSize);
+    juce::AudioBuffer<double> doubleBuffer(config.doublePrecision ? config.numChannels : 0, config.blockSize);
+
+    auto numBlocks = static_cast<int>(seconds * config.sampleRate / config.blockSize);
+    std::vector<double> callbackSeconds;
+    callbackSeconds.reserve(static_cast<size_t>(numBlocks));
+
+    auto noisePosition = 0;
+    juce::int64 totalTicks = 0;
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        // Continuous automation keeps every active tap's smoothing moving
+        if (config.automated)
+        {
+            auto phase = static_cast<float>(block) * static_cast<float>(config.blockSize) / static_cast<float>(config.sampleRate);
+
+            for (int i = 0; i < config.activeTaps; ++i)
+            {
+                auto lfo = 0.5f + 0.5f * std::sin(juce::MathConstants<float>::twoPi * (0.3f * phase + 0.07f * i));
+                setParameter(gainParams[i], 30.0f + 60.0f * lfo);
+                setParameter(panParams[i], 100.0f * lfo);
+                setParameter(delayParams[i], 40.0f + 230.0f * static_cast<float>(i % 17) + 50.0f * lfo);
+            }
+        }
+
+        if (noisePosition + config.blockSize > noise.getNumSamples())
+            noisePosition = 0;
+
+        auto ticks = config.doublePrecision ? processNoise(*processor, doubleBuffer, noise, noisePosition)
+                                            : processNoise(*processor, floatBuffer, noise, noisePosition);
+
+        noisePosition += config.blockSize;
+
+        totalTicks += ticks;
+        callbackSeconds.push_back(juce::Time::highResolutionTicksToSeconds(ticks));
+    }
+
+    processor->releaseResources();
+
+    std::sort(callbackSeconds.begin(), callbackSeconds.end());
+
+    RunResult result;
+    result.config = config;
+    result.numSamples = static_cast<juce::int64>(numBlocks) * config.blockSize;
+
+    auto totalSeconds = juce::Time::highResolutionTicksToSeconds(totalTicks);
+    result.nsPerSample = totalSeconds * 1.0e9 / static_cast<double>(juce::jmax<juce::int64>(result.numSamples, 1));
+    result.realtimeFactor = totalSeconds > 0.0 ? (static_cast<double>(result.numSamples) / config.sampleRate) / totalSeconds : 0.0;
+
+    if (callbackSeconds.empty())
+        callbackSeconds.push_back(0.0);
+
+    result.p50 = percentile(callbackSeconds, 0.5) * 1.0e6;
+    result.p90 = percentile(callbackSeconds, 0.9) * 1.0e6;
+    result.p99 = percentile(callbackSeconds, 0.99) * 1.0e6;
+    result.p999 = percentile(callbackSeconds, 0.999) * 1.0e6;
+    result.max = callbackSeconds.back() * 1.0e6;
+
+    return result;
+}
+
+//==============================================================================
+static juce::var toJson(const juce::Array<RunResult>& results, double seconds)
+{
+    juce::Array<juce::var> runs;
+
+    for (auto& r : results)
+    {
+        auto* callback = new juce::DynamicObject();
+        callback->setProperty("p50", r.p50);
+        callback->setProperty("p90", r.p90);
+        callback->setProperty("p99", r.p99);
+        callback->setProperty("p99.9", r.p999);
+        callback->setProperty("max", r.max);
+
+        auto* run = new juce::DynamicObject();
+        run->setProperty("sampleRate", r.config.sampleRate);
+        run->setProperty("blockSize", r.config.blockSize);
+        run->setProperty("activeTaps", r.config.activeTaps);
+        run->setProperty("automation", r.config.automated ? "continuous" : "settled");
+        run->setProperty("channels", r.config.numChannels);
+        run->setProperty("precision", r.config.doublePrecision ? "double" : "float");
+        run->setProperty("offline", r.config.offline);
+        run->setProperty("timeMode", r.config.crossfade ? "crossfade" : "ramp");
+        run->setProperty("feedback", r.config.feedback);
+        run->setProperty("filters", r.config.filtered);
+        run->setProperty("lfo", r.config.modulated);
+        run->setProperty("interpolation", interpolationNames[r.config.interpolation]);
+        run->setProperty("longDelay", r.config.longDelay);
+        run->setProperty("samples", r.numSamples);
+        run->setProperty("nsPerSample", r.nsPerSample);
+        run->setProperty("realtimeFactor", r.realtimeFactor);
+        run->setProperty("callbackMicroseconds", juce::var(callback));
+        runs.add(juce::var(run));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("benchmark", "SequencedDelay");
+    root->setProperty("version", 1);
+    root->setProperty("secondsPerRun", seconds);
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty("results", runs);
+
+    return juce::var(root);
+}
+
+//==============================================================================
+// Reports the size and per-instance save and load cost of the binary state
+// against the XML state earlier versions wrote
+static int runStateBenchmark(int iterations)
+{
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+    juce::Random random(0x5eed);
+
+    // Move every parameter off its default so nothing is skipped
+    for (auto* param : processor->getParameters())
+        param->setValueNotifyingHost(random.nextFloat());
+
+    // Same tree AudioProcessorValueTreeState::copyState produces
+    auto writeLegacy = [&processor] (juce::MemoryBlock& dest)
+    {
+        juce::ValueTree state("Main");
+
+        for (auto* param : processor->getParameters())
+        {
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+            {
+                juce::ValueTree child("PARAM");
+                child.setProperty("id", ranged->paramID, nullptr);
+                child.setProperty("value", ranged->convertFrom0to1(ranged->getValue()), nullptr);
+                state.appendChild(child, nullptr);
+            }
+        }
+
+        std::unique_ptr<juce::XmlElement> xml(state.createXml());
+        juce::AudioProcessor::copyXmlToBinary(*xml, dest);
+    };
+
+    auto time = [iterations] (std::function<void()> action)
+    {
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < iterations; ++i)
+            action();
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        return seconds * 1.0e6 / juce::jmax(iterations, 1);
+    };
+
+    juce::MemoryBlock binary, legacy;
+    processor->getStateInformation(binary);
+    writeLegacy(legacy);
+
+    auto binarySave = time([&] { processor->getStateInformation(binary); });
+    auto binaryLoad = time([&] { processor->setStateInformation(binary.getData(), static_cast<int>(binary.getSize())); });
+    auto legacySave = time([&] { writeLegacy(legacy); });
+    auto legacyLoad = time([&] { processor->setStateInformation(legacy.getData(), static_cast<int>(legacy.getSize())); });
+
+    std::printf("%8s %8s %10s %10s\n", "format", "bytes", "save us", "load us");
+    std::printf("%8s %8d %10.2f %10.2f\n", "binary", static_cast<int>(binary.getSize()), binarySave, binaryLoad);
+    std::printf("%8s %8d %10.2f %10.2f\n", "xml", static_cast<int>(legacy.getSize()), legacySave, legacyLoad);
+
+    return 0;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // The processor's parameters and components need a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    if (args.contains("--golden"))
+    {
+        GoldenOptions options;
+        options.tolerance = getOption(args, "--tolerance", "1e-5").getFloatValue();
+        options.bitExact = args.contains("--bit-exact");
+
+        auto cwd = juce::File::getCurrentWorkingDirectory();
+        auto writeFile = getOption(args, "--golden-write", {});
+        auto checkFile = getOption(args, "--golden-check", {});
+
+        if (writeFile.isNotEmpty())
+            options.writeFile = cwd.getChildFile(writeFile);
+
+        if (checkFile.isNotEmpty())
+            options.checkFile = cwd.getChildFile(checkFile);
+
+        return runGoldenRenders(options) == 0 ? 0 : 1;
+    }
+
+    if (args.contains("--check"))
+        return runBehaviourChecks(getOption(args, "--check", {})) == 0 ? 0 : 1;
+
+    if (args.contains("--state"))
+        return runStateBenchmark(juce::jmax(1, getOption(args, "--state", "10000").getIntValue()));
+
+    auto seconds = getOption(args, "--seconds", "120").getDoubleValue();
+    auto rates = parseList(getOption(args, "--rates", "44100,48000,96000,192000"));
+    auto blocks = parseList(getOption(args, "--blocks", "16,32,64,128,256,512,1024,2048,4096"));
+    auto tapCounts = parseList(getOption(args, "--taps", "1,4,16"));
+    auto jsonFile = getOption(args, "--json", {});
+    auto numChannels = juce::jlimit(2, 16, getOption(args, "--channels", "2").getIntValue());
+    auto doublePrecision = args.contains("--double");
+    auto offline = args.contains("--offline");
+    auto crossfade = args.contains("--crossfade");
+    auto feedback = juce::jlimit(0.0f, 100.0f, getOption(args, "--feedback", "0").getFloatValue());
+    auto filtered = args.contains("--filter");
+    auto modulated = args.contains("--lfo");
+    auto interpolation = juce::jmax(0, interpolationNames.indexOf(getOption(args, "--interp", "none")));
+
+    auto longDelay = args.contains("--long");
+
+    // Ten seconds of noise at the highest rate, looped for longer renders
+    juce::AudioBuffer<float> noise(2, 192000 * 10);
+    juce::Random random(0x5eed);
+
+    for (int channel = 0; channel < noise.getNumChannels(); ++channel)
+        for (int i = 0; i < noise.getNumSamples(); ++i)
+            noise.setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+    juce::Array<RunResult> results;
+
+    std::printf("%8s %6s %5s %11s %10s %9s %9s %9s %9s %9s %9s\n", "rate", "block", "taps", "automation",
+        "ns/sample", "x realtime", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+
+    for (auto rate : rates)
+        for (auto block : blocks)
+            for (auto taps : tapCounts)
+                for (auto automated : { false, true })
+                {
+                    RunConfig config{ static_cast<double>(rate), block, juce::jlimit(0, num_delays, taps), automated, numChannels, doublePrecision, offline, crossfade, feedback, filtered, modulated, interpolation, longDelay };
+                    auto r = run(config, seconds, noise);
+                    results.add(r);
+
+                    std::printf("%8d %6d %5d %11s %10.2f %10.1f %9.2f %9.2f %9.2f %9.2f %9.2f\n", rate, block,
+                        config.activeTaps, automated ? "continuous" : "settled", r.nsPerSample, r.realtimeFactor,
+                        r.p50, r.p90, r.p99, r.p999, r.max);
+                    std::fflush(stdout);
+                }
+
+    if (jsonFile.isNotEmpty())
+    {
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile(jsonFile);
+
+        if (!file.replaceWithText(juce::JSON::toString(toJson(results, seconds))))
+        {
+            std::fprintf(stderr, "Could not write %s\n", file.getFullPathName().toRawUTF8());
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Linear ramps evaluated a block at a time. The arithmetic matches
+// juce::SmoothedValue<T, Linear> sample for sample, but a whole block is
+// produced in one call: either a filled ramp buffer or nothing when settled.
+
+// Same arithmetic as juce::SmoothedValue<T, Linear>::setTargetValue
+template <typename T>
+inline void setRampTarget(T& current, T& target, T& step, int& countdown, int rampLength, T newValue)
+{
+    if (newValue == target)
+        return;
+
+    if (rampLength <= 0)
+    {
+        current = target = newValue;
+        countdown = 0;
+        return;
+    }
+
+    target = newValue;
+    countdown = rampLength;
+    step = (target - current) / static_cast<T>(countdown);
+}
+
+// Same arithmetic as juce::SmoothedValue<T, Linear>::getNextValue
+template <typename T>
+inline T nextRampValue(T& current, const T& target, const T& step, int& countdown)
+{
+    if (countdown <= 0)
+        return target;
+
+    if (--countdown > 0)
+        current += step;
+    else
+        current = target;
+
+    return current;
+}
+
+// Same arithmetic as juce::SmoothedValue<T, Linear>::skip
+template <typename T>
+inline void skipRamp(T& current, const T& target, const T& step, int& countdown, int numSamples)
+{
+    if (numSamples >= countdown)
+    {
+        current = target;
+        countdown = 0;
+        return;
+    }
+
+    current += step * static_cast<T>(numSamples);
+    countdown -= numSamples;
+}
+
+// Writes the next values of a moving ramp into dest
+// @return - Number of ramp values written, 0 if the ramp has settled. All
+//           samples past that point are at the target value.
+template <typename T>
+inline int fillRamp(T& current, const T& target, const T& step, int& countdown, T* dest, int numSamples)
+{
+    auto numRampSamples = juce::jlimit(0, numSamples, countdown);
+
+    for (int i = 0; i < numRampSamples; ++i)
+        dest[i] = nextRampValue(current, target, step, countdown);
+
+    return numRampSamples;
+}
+
+//==============================================================================
+// Single smoothed value with a block interface, used in place of
+// juce::SmoothedValue where the per-sample getNextValue() call is too costly.
+template <typename T>
+class RampedValue
+{
+public:
+    //==========================================================================
+    RampedValue(T initialValue = T()) : current(initialValue), target(initialValue) {}
+
+    inline void reset(double sampleRate, double rampLengthInSeconds)
+    {
+        rampLength = static_cast<int>(std::floor(rampLengthInSeconds * sampleRate));
+        current = target;
+        countdown = 0;
+    }
+
+    inline void setTargetValue(T newValue)
+    {
+        setRampTarget(current, target, step, countdown, rampLength, newValue);
+    }
+
+    inline void setCurrentAndTargetValue(T newValue)
+    {
+        current = target = newValue;
+        countdown = 0;
+    }
+
+    inline int fillRamp(T* dest, int numSamples)
+    {
+        return ::fillRamp(current, target, step, countdown, dest, numSamples);
+    }
+
+    inline void skip(int numSamples)
+    {
+        skipRamp(current, target, step, countdown, numSamples);
+    }
+
+    inline T getCurrentValue() const { return current; }
+    inline T getTargetValue() const { return target; }
+    inline bool isSmoothing() const { return countdown > 0; }
+
+private:
+    //==========================================================================
+    T current, target;
+    T step = T();
+    int countdown{ 0 };
+    int rampLength{ 0 };
+};
@@ -0,0 +1,266 @@
+#include "DelayLine.h"
+
+//==============================================================================
+// @param minimumLength - Shortest ring length needed, rounded up to a power of two
+// @param maxReadLength - Longest contiguous read, usually the maximum block size
+template <typename SampleType>
+void DelayLine<SampleType>::setSize(int channels, int minimumLength, int maxReadLength, Storage newStorage)
+{
+    storage = newStorage;
+    numChannels = channels;
+    maxRead = juce::jmax(maxReadLength, 1);
+
+    if (isCompact())
+    {
+        // A write rescales the whole block it ends in, so the block past the
+        // newest samples is kept out of reach as well
+        length = juce::nextPowerOfTwo(juce::jmax(minimumLength, maxRead + compact_block_size));
+        guard = maxRead + compact_block_size;
+
+        buffer.setSize(0, 0);
+        mantissas.malloc(static_cast<size_t>(numChannels) * static_cast<size_t>(length));
+        scales.malloc(static_cast<size_t>(numChannels) * static_cast<size_t>(length / compact_block_size));
+    }
+    else
+    {
+        length = juce::nextPowerOfTwo(juce::jmax(minimumLength, maxRead + kernel_span));
+        guard = maxRead + kernel_span;
+
+        buffer.setSize(numChannels, length + guard);
+        mantissas.free();
+        scales.free();
+    }
+
+    mask = length - 1;
+    clear();
+}
+
+template <typename SampleType>
+void DelayLine<SampleType>::clear()
+{
+    if (isCompact())
+    {
+        mantissas.clear(static_cast<size_t>(numChannels) * static_cast<size_t>(length));
+        scales.clear(static_cast<size_t>(numChannels) * static_cast<size_t>(length / compact_block_size));
+    }
+    else
+    {
+        buffer.clear();
+    }
+
+    writePosition = 0;
+}
+
+// Copies every sample of a shorter or equal line, oldest first, so each one
+// keeps its distance from the write position
+template <typename SampleType>
+void DelayLine<SampleType>::copyHistoryFrom(const DelayLine<SampleType>& other)
+{
+    copyHistoryFrom(other, other.writePosition, 0);
+}
+
+// The skipped samples are left silent; numSkipped is a whole number of
+// compact blocks, so catchUpFrom() can fill them in without disturbing the
+// copied ones
+template <typename SampleType>
+void DelayLine<SampleType>::copyHistoryFrom(const DelayLine<SampleType>& other, int otherWritePosition, int numSkipped)
+{
+    jassert(length >= other.length && getNumChannels() == other.getNumChannels());
+    jassert(numSkipped <= other.length && numSkipped % compact_block_size == 0);
+
+    clear();
+
+    copyRangeFrom(other, otherWritePosition + numSkipped, numSkipped, other.length - numSkipped);
+    writePosition = wrap(other.length);
+}
+
+// Of the skipped samples, the oldest numWritten have since been overwritten
+// and stay silent, as they would have fallen off the end of other anyway
+template <typename SampleType>
+void DelayLine<SampleType>::catchUpFrom(const DelayLine<SampleType>& other, int otherWritePosition, int numSkipped,
+    int numWritten)
+{
+    jassert(numWritten <= numSkipped);
+
+    auto start = writePosition - other.length;
+
+    copyRangeFrom(other, otherWritePosition + numWritten, start + numWritten, numSkipped - numWritten);
+    copyRangeFrom(other, otherWritePosition, writePosition, numWritten);
+    advance(numWritten);
+}
+
+// Writes numSamples of other's ring from start on at position. A compact
+// line is decoded a chunk at a time on the stack, as this runs on the audio
+// thread
+template <typename SampleType>
+void DelayLine<SampleType>::copyRangeFrom(const DelayLine<SampleType>& other, int start, int position, int numSamples)
+{
+    if (!other.isCompact())
+    {
+        auto first = other.wrap(start);
+        auto numSamplesToEnd = juce::jmin(numSamples, other.length - first);
+
+        for (int channel = 0; channel < getNumChannels(); ++channel)
+        {
+            writeAt(channel, position, other.buffer.getReadPointer(channel, first), numSamplesToEnd);
+            writeAt(channel, position + numSamplesToEnd, other.buffer.getReadPointer(channel),
+                numSamples - numSamplesToEnd);
+        }
+
+        return;
+    }
+
+    constexpr int chunk_size = 256;
+    SampleType chunk [chunk_size];
+
+    for (int done = 0; done < numSamples; done += chunk_size)
+    {
+        auto numChunk = juce::jmin(chunk_size, numSamples - done);
+
+        for (int channel = 0; channel < getNumChannels(); ++channel)
+        {
+            other.read(channel, start + done, chunk, numChunk);
+            writeAt(channel, position + done, chunk, numChunk);
+        }
+    }
+}
+
+// Writes a block at the write position
+template <typename SampleType>
+void DelayLine<SampleType>::write(int channel, const SampleType* data, int numSamples)
+{
+    writeAt(channel, writePosition, data, numSamples);
+}
+
+// Writes a block at position, splitting at the wrap point
+template <typename SampleType>
+void DelayLine<SampleType>::writeAt(int channel, int position, const SampleType* data, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    auto start = wrap(position);
+    int numSamplesToEnd = juce::jmin(numSamples, length - start);
+
+    copyToRing(channel, start, data, numSamplesToEnd);
+
+    if (numSamplesToEnd < numSamples)
+        copyToRing(channel, 0, data + numSamplesToEnd, numSamples - numSamplesToEnd);
+}
+
+// Copies into the ring and keeps the guard region past the end in sync
+template <typename SampleType>
+void DelayLine<SampleType>::copyToRing(int channel, int position, const SampleType* data, int numSamples)
+{
+    if (isCompact())
+    {
+        encode(channel, position, data, numSamples);
+        return;
+    }
+
+    buffer.copyFrom(channel, position, data, numSamples);
+
+    if (position < guard)
+    {
+        int numToMirror = juce::jmin(numSamples, guard - position);
+        buffer.copyFrom(channel, length + position, data, numToMirror);
+    }
+}
+
+// Decodes or copies, splitting where the ring wraps
+template <typename SampleType>
+void DelayLine<SampleType>::read(int channel, int position, SampleType* dest, int numSamples) const
+{
+    if (!isCompact())
+    {
+        auto start = wrap(position);
+        auto numSamplesToEnd = juce::jmin(numSamples, length - start);
+
+        juce::FloatVectorOperations::copy(dest, buffer.getReadPointer(channel, start), numSamplesToEnd);
+        juce::FloatVectorOperations::copy(dest + numSamplesToEnd, buffer.getReadPointer(channel),
+            numSamples - numSamplesToEnd);
+        return;
+    }
+
+    auto* channelMantissas = mantissas.get() + channel * length;
+    auto* channelScales = scales.get() + channel * (length / compact_block_size);
+
+    while (numSamples > 0)
+    {
+        auto start = wrap(position);
+        auto numBlock = juce::jmin(numSamples, compact_block_size - start % compact_block_size);
+        auto* source = channelMantissas + start;
+        auto scale = static_cast<SampleType>(channelScales[start / compact_block_size]);
+
+        // Plain loop, the compiler widens and scales a register at a time
+        for (int i = 0; i < numBlock; ++i)
+            dest[i] = static_cast<SampleType>(source[i]) * scale;
+
+        position += numBlock;
+        dest += numBlock;
+        numSamples -= numBlock;
+    }
+}
+
+// Encodes into compact blocks. A write that starts partway into a block is
+// merged with the samples already in it and the block rescaled; the rest of
+// the block, still holding the previous lap, is cleared.
+template <typename SampleType>
+void DelayLine<SampleType>::encode(int channel, int position, const SampleType* data, int numSamples)
+{
+    auto* channelMantissas = mantissas.get() + channel * length;
+    auto* channelScales = scales.get() + channel * (length / compact_block_size);
+
+    while (numSamples > 0)
+    {
+        auto block = position / compact_block_size;
+        auto blockStart = block * compact_block_size;
+        auto offset = position - blockStart;
+        auto numBlock = juce::jmin(numSamples, compact_block_size - offset);
+        auto* dest = channelMantissas + blockStart;
+
+        if (offset == 0)
+        {
+            encodeBlock(data, numBlock, dest, channelScales[block]);
+        }
+        else
+        {
+            SampleType merged [compact_block_size];
+            read(channel, blockStart, merged, offset);
+            std::copy(data, data + numBlock, merged + offset);
+            encodeBlock(merged, offset + numBlock, dest, channelScales[block]);
+        }
+
+        std::fill(dest + offset + numBlock, dest + compact_block_size, juce::int16(0));
+
+        position += numBlock;
+        data += numBlock;
+        numSamples -= numBlock;
+    }
+}
+
+// Scales a block so its peak lands on the largest mantissa and rounds it
+template <typename SampleType>
+void DelayLine<SampleType>::encodeBlock(const SampleType* data, int numSamples, juce::int16* dest, float& scale)
+{
+    constexpr auto max_mantissa = SampleType(32767);
+
+    auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+    auto peak = juce::jmax(-range.getStart(), range.getEnd());
+
+    scale = static_cast<float>(peak / max_mantissa);
+
+    // The mantissas are decoded with the stored float scale, so they are
+    // encoded with its inverse too
+    auto inverse = scale > 0.0f ? SampleType(1) / static_cast<SampleType>(scale) : SampleType(0);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto value = juce::jlimit(-max_mantissa, max_mantissa, data[i] * inverse);
+        dest[i] = static_cast<juce::int16>(value + (value < SampleType(0) ? SampleType(-0.5) : SampleType(0.5)));
+    }
+}
+
+//==============================================================================
+template class DelayLine<float>;
+template class DelayLine<double>;
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Multichannel ring buffer with a power-of-two length. The first
+// maxReadLength + kernel_span samples are mirrored past the end of the ring,
+// so any read of up to maxReadLength samples starting inside the ring is one
+// contiguous span, as is a kernel's read of up to kernel_span samples.
+// Instantiated for float and double in DelayLine.cpp.
+//
+// A compact line stores 16-bit mantissas instead, sharing one scale per
+// block of compact_block_size samples, in about half the memory of float.
+// Writes encode and reads decode, so it has no contiguous spans and is read
+// through getCompactView() or read() instead of getReadPointer().
+template <typename SampleType>
+class DelayLine
+{
+public:
+    //==========================================================================
+    enum class Storage
+    {
+        full,
+        compact
+    };
+
+    static constexpr int compact_block_size = 32;
+
+    // Most samples an interpolation kernel reads from one read pointer
+    static constexpr int kernel_span = 4;
+
+    void setSize(int numChannels, int minimumLength, int maxReadLength, Storage storage = Storage::full);
+    void clear();
+
+    // Copies between lines of either storage
+    void copyHistoryFrom(const DelayLine& other);
+
+    // Copies other's history as it was with its write position at
+    // otherWritePosition, leaving out the oldest numSkipped samples.
+    // catchUpFrom() then completes the copy from the line as it is now, once
+    // numWritten more samples have been written to it.
+    void copyHistoryFrom(const DelayLine& other, int otherWritePosition, int numSkipped);
+    void catchUpFrom(const DelayLine& other, int otherWritePosition, int numSkipped, int numWritten);
+
+    void write(int channel, const SampleType* data, int numSamples);
+    inline void advance(int numSamples)
+    {
+        writePosition = wrap(writePosition + numSamples);
+        writeCount += numSamples;
+    }
+
+    // Copies or decodes numSamples starting at position into dest
+    void read(int channel, int position, SampleType* dest, int numSamples) const;
+
+    //==========================================================================
+    inline int wrap(int position) const { return position & mask; }
+
+    // Returns a span of at least getMaxReadLength() samples starting at
+    // position. Full storage only
+    inline const SampleType* getReadPointer(int channel, int position) const
+    {
+        jassert(!isCompact());
+        return buffer.getReadPointer(channel, wrap(position));
+    }
+
+    // Decodes compact samples one at a time where they are indexed, so code
+    // written against getReadPointer() reads a compact line unchanged
+    class CompactView
+    {
+    public:
+        struct Span
+        {
+            inline SampleType operator[](int index) const
+            {
+                auto position = (start + index) & mask;
+                return static_cast<SampleType>(mantissas[position])
+                     * static_cast<SampleType>(scales[position / compact_block_size]);
+            }
+
+            inline SampleType operator*() const { return (*this)[0]; }
+
+            const juce::int16* mantissas;
+            const float* scales;
+            int start;
+            int mask;
+        };
+
+        explicit CompactView(const DelayLine& l) : line(l) {}
+
+        inline Span getReadPointer(int channel, int position) const
+        {
+            return { line.mantissas.get() + channel * line.length,
+                     line.scales.get() + channel * (line.length / compact_block_size), line.wrap(position), line.mask };
+        }
+
+        inline void read(int channel, int position, SampleType* dest, int numSamples) const
+        {
+            line.read(channel, position, dest, numSamples);
+        }
+
+        inline int getWritePosition() const { return line.writePosition; }
+
+    private:
+        const DelayLine& line;
+    };
+
+    inline CompactView getCompactView() const
+    {
+        jassert(isCompact());
+        return CompactView(*this);
+    }
+
+    inline Storage getStorage() const { return storage; }
+    inline bool isCompact() const { return storage == Storage::compact; }
+
+    inline int getNumChannels() const { return numChannels; }
+    inline int getLength() const { return length; }
+    inline int getMaxReadLength() const { return maxRead; }
+
+    // Longest delay that a full block can read without seeing its own writes
+    inline int getMaxDelay() const { return length - guard; }
+    inline int getGuardLength() const { return guard; }
+    inline int getWritePosition() const { return writePosition; }
+
+    // Samples advanced over since the line was made
+    inline juce::int64 getWriteCount() const { return writeCount; }
+
+private:
+    //==========================================================================
+    void writeAt(int channel, int position, const SampleType* data, int numSamples);
+    void copyToRing(int channel, int position, const SampleType* data, int numSamples);
+    void copyRangeFrom(const DelayLine& other, int start, int position, int numSamples);
+
+    void encode(int channel, int position, const SampleType* data, int numSamples);
+    static void encodeBlock(const SampleType* data, int numSamples, juce::int16* dest, float& scale);
+
+    //==========================================================================
+    juce::AudioBuffer<SampleType> buffer;
+
+    // Compact storage, length mantissas and length / compact_block_size
+    // scales per channel
+    juce::HeapBlock<juce::int16> mantissas;
+    juce::HeapBlock<float> scales;
+
+    Storage storage{ Storage::full };
+
+    int numChannels{ 0 };
+    int length{ 0 };
+    int mask{ 0 };
+    int guard{ 0 };
+    int maxRead{ 0 };
+
+    int writePosition{ 0 };
+    juce::int64 writeCount{ 0 };
+};
@@ -0,0 +1,234 @@
+#include "DelayLineResizer.h"
+
+//==============================================================================
+DelayLineResizerThread::DelayLineResizerThread() : juce::Thread("SequencedDelay line resizer")
+{
+}
+
+DelayLineResizerThread::~DelayLineResizerThread()
+{
+    stopThread(1000);
+}
+
+// Instances may be prepared on different threads at once
+void DelayLineResizerThread::add(Client* client)
+{
+    const juce::ScopedLock sl(lock);
+    clients.addIfNotAlreadyThere(client);
+
+    if (!isThreadRunning())
+        startThread();
+}
+
+void DelayLineResizerThread::remove(Client* client)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        clients.removeFirstMatchingValue(client);
+    }
+
+    // Waits out a service that started before client was removed
+    const juce::ScopedLock sl(client->serviceLock);
+}
+
+// lock only guards the list, so a long copy for one client does not hold up
+// other instances being prepared or released
+void DelayLineResizerThread::run()
+{
+    while (!threadShouldExit())
+    {
+        for (int i = 0; !threadShouldExit(); ++i)
+        {
+            Client* client = nullptr;
+
+            {
+                const juce::ScopedLock sl(lock);
+
+                if (i >= clients.size())
+                    break;
+
+                client = clients[i];
+                client->serviceLock.enter();
+            }
+
+            client->service();
+            client->serviceLock.exit();
+        }
+
+        wait(poll_interval_ms);
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+DelayLineResizer<SampleType>::DelayLineResizer()
+{
+}
+
+template <typename SampleType>
+DelayLineResizer<SampleType>::~DelayLineResizer()
+{
+    release();
+}
+
+template <typename SampleType>
+void DelayLineResizer<SampleType>::prepare(const DelayLine<SampleType>& line)
+{
+    release();
+
+    live = &line;
+    numChannels = line.getNumChannels();
+    maxReadLength = line.getMaxReadLength();
+    allocatedLength = line.getLength();
+    requestedLength = line.getLength();
+    allocatedStorage = line.getStorage();
+    requestedStorage = line.getStorage();
+    isGrowing = false;
+
+    thread->add(this);
+    isPolled = true;
+}
+
+template <typename SampleType>
+void DelayLineResizer<SampleType>::release()
+{
+    if (isPolled)
+        thread->remove(this);
+
+    isPolled = false;
+    freeLines();
+}
+
+template <typename SampleType>
+void DelayLineResizer<SampleType>::freeLines()
+{
+    delete allocated.exchange(nullptr);
+    delete copying.exchange(nullptr);
+    delete pending.exchange(nullptr);
+    delete retired.exchange(nullptr);
+}
+
+//==============================================================================
+template <typename SampleType>
+void DelayLineResizer<SampleType>::request(int minimumLength)
+{
+    if (minimumLength > requestedLength.load())
+        requestedLength = minimumLength;
+}
+
+template <typename SampleType>
+void DelayLineResizer<SampleType>::requestStorage(Storage storage)
+{
+    if (storage != requestedStorage.load())
+        requestedStorage = storage;
+}
+
+template <typename SampleType>
+bool DelayLineResizer<SampleType>::swapIfReady(DelayLine<SampleType>& line)
+{
+    // Wait until the previous line has been freed
+    if (retired.load() != nullptr)
+        return false;
+
+    if (auto* grown = allocated.exchange(nullptr))
+    {
+        // An offline growNow may have overtaken this line
+        if (!isReplacement(*grown, line))
+        {
+            retired = grown;
+            return false;
+        }
+
+        // The next compact write rescales the block it starts in, so the
+        // snapshot starts with that block as if it were still to be written
+        auto position = line.getWritePosition();
+        auto numInBlock = position % DelayLine<SampleType>::compact_block_size;
+
+        snapshotPosition = position - numInBlock;
+        snapshotCount = line.getWriteCount() - numInBlock;
+        numSkipped = juce::jmin(static_cast<int>(catch_up_length), line.getLength());
+        copying = grown;
+        return false;
+    }
+
+    auto* grown = pending.exchange(nullptr);
+
+    if (grown == nullptr)
+        return false;
+
+    // Past catch_up_length the background copy may have read samples as they
+    // were written. Copying the whole history here would take too long, so
+    // the line goes back for a fresh snapshot instead.
+    auto numWritten = line.getWriteCount() - snapshotCount;
+
+    if (numWritten > numSkipped)
+    {
+        allocated = grown;
+        return false;
+    }
+
+    grown->catchUpFrom(line, snapshotPosition, numSkipped, static_cast<int>(numWritten));
+
+    std::swap(line, *grown);
+
+    retired = grown;
+    return true;
+}
+
+// A line is swapped in if it is longer, or converted and at least as long
+template <typename SampleType>
+bool DelayLineResizer<SampleType>::isReplacement(const DelayLine<SampleType>& grown, const DelayLine<SampleType>& line)
+{
+    return grown.getLength() > line.getLength()
+        || (grown.getStorage() != line.getStorage() && grown.getLength() >= line.getLength());
+}
+
+template <typename SampleType>
+void DelayLineResizer<SampleType>::growNow(DelayLine<SampleType>& line, int minimumLength, Storage storage)
+{
+    while (copying.load() != nullptr)
+        juce::Thread::yield();
+
+    // Its history is from before line changes here, and may be shorter
+    if (auto* stale = pending.exchange(nullptr))
+        delete retired.exchange(stale);
+
+    DelayLine<SampleType> grown;
+    grown.setSize(line.getNumChannels(), juce::jmax(minimumLength, line.getLength()), line.getMaxReadLength(), storage);
+    grown.copyHistoryFrom(line);
+    std::swap(line, grown);
+}
+
+//==============================================================================
+template <typename SampleType>
+void DelayLineResizer<SampleType>::service()
+{
+    if (auto* done = retired.exchange(nullptr))
+    {
+        delete done;
+        isGrowing = false;
+    }
+
+    auto wanted = requestedLength.load();
+    auto storage = requestedStorage.load();
+
+    if (auto* grown = copying.load())
+    {
+        grown->copyHistoryFrom(*live, snapshotPosition, numSkipped);
+        pending = grown;
+        copying = nullptr;
+    }
+    else if ((wanted > allocatedLength || storage != allocatedStorage) && !isGrowing)
+    {
+        auto grown = std::make_unique<DelayLine<SampleType>>();
+        grown->setSize(numChannels, juce::jmax(wanted, allocatedLength), maxReadLength, storage);
+        allocatedLength = grown->getLength();
+        allocatedStorage = storage;
+        isGrowing = true;
+        allocated = grown.release();
+    }
+}
+
+//==============================================================================
+template class DelayLineResizer<float>;
+template class DelayLineResizer<double>;
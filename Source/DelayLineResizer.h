@@ -0,0 +1,129 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DelayLine.h"
+
+//==============================================================================
+// The background thread of every DelayLineResizer in the process, polling
+// each in turn
+class DelayLineResizerThread : private juce::Thread
+{
+public:
+    // What the thread polls
+    struct Client
+    {
+        virtual ~Client() = default;
+
+        // Background thread: acts on whatever the audio thread asked for
+        virtual void service() = 0;
+
+        // Held while service() runs
+        juce::CriticalSection serviceLock;
+    };
+
+    //==========================================================================
+    DelayLineResizerThread();
+    ~DelayLineResizerThread() override;
+
+    // Starts polling client
+    void add(Client* client);
+
+    // Stops polling client, waiting for its service in progress to finish
+    void remove(Client* client);
+
+private:
+    //==========================================================================
+    void run() override;
+
+    static constexpr int poll_interval_ms = 20;
+
+    juce::CriticalSection lock;
+    juce::Array<Client*> clients;
+};
+
+//==============================================================================
+// Grows a DelayLine without allocating on the audio thread. The audio thread
+// asks for a length with request(); a background thread allocates the larger
+// line and publishes it through an atomic pointer, and swapIfReady() moves it
+// into place with the existing history. The replaced line is handed back to
+// the background thread to be freed. A change of storage is made the same
+// way, with a line of the new storage at least as long.
+//
+// The history of a long line takes too long to copy in one block, so the
+// background thread copies it from a snapshot of the write position. It
+// leaves out the oldest catch_up_length samples, which the audio thread may
+// overwrite meanwhile; swapIfReady() copies those that are left and the
+// samples written since. A copy that took longer is started again from a new
+// snapshot, never finished on the audio thread.
+//
+// Signalling a thread would take a lock on the audio thread, so the shared
+// DelayLineResizerThread polls the requests instead.
+template <typename SampleType>
+class DelayLineResizer : private DelayLineResizerThread::Client
+{
+public:
+    using Storage = typename DelayLine<SampleType>::Storage;
+
+    //==========================================================================
+    DelayLineResizer();
+    ~DelayLineResizer() override;
+
+    // Starts allocating lines shaped like line, dropping any from before.
+    // line is read by the background thread until release()
+    void prepare(const DelayLine<SampleType>& line);
+    void release();
+
+    //==========================================================================
+    // Audio thread: asks for a line of at least minimumLength samples
+    void request(int minimumLength);
+
+    // Audio thread: asks for lines of this storage from now on
+    void requestStorage(Storage storage);
+
+    // Audio thread: swaps a grown line in if one is ready
+    // @return - True if line was replaced
+    bool swapIfReady(DelayLine<SampleType>& line);
+
+    // Grows or converts line on the calling thread, for offline rendering
+    // only. Waits for a history copy in progress and drops its line
+    void growNow(DelayLine<SampleType>& line, int minimumLength, Storage storage);
+
+private:
+    //==========================================================================
+    void service() override;
+    void freeLines();
+
+    static bool isReplacement(const DelayLine<SampleType>& grown, const DelayLine<SampleType>& line);
+
+    // A whole number of compact blocks. A copy that outlasts it is retried,
+    // so it only has to cover the poll interval and a typical copy
+    static constexpr int catch_up_length = 32768;
+
+    //==========================================================================
+    juce::SharedResourcePointer<DelayLineResizerThread> thread;
+    bool isPolled{ false };
+
+    std::atomic<int> requestedLength{ 0 };
+    std::atomic<Storage> requestedStorage{ Storage::full };
+
+    // A line moves from allocated (waiting for a snapshot) to copying (the
+    // background thread is copying its history) to pending, then is swapped
+    // and retired
+    std::atomic<DelayLine<SampleType>*> allocated{ nullptr };
+    std::atomic<DelayLine<SampleType>*> copying{ nullptr };
+    std::atomic<DelayLine<SampleType>*> pending{ nullptr };
+    std::atomic<DelayLine<SampleType>*> retired{ nullptr };
+
+    // The snapshot, written by the audio thread before it publishes copying
+    int snapshotPosition{ 0 };
+    int numSkipped{ 0 };
+    juce::int64 snapshotCount{ 0 };
+
+    // Only touched by the background thread, or while this is not polled
+    const DelayLine<SampleType>* live{ nullptr };
+    int numChannels{ 0 };
+    int maxReadLength{ 0 };
+    int allocatedLength{ 0 };
+    Storage allocatedStorage{ Storage::full };
+    bool isGrowing{ false };
+};
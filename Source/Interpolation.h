@@ -0,0 +1,147 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DelayLine.h"
+
+//==============================================================================
+// Fractional delay kernels for the tap reads. Every kernel is a
+// specialisation of Interpolator, so the read loop is compiled once per
+// kernel and a tap only runs the one it asks for.
+//
+// read() returns the line time + fraction samples before position, where the
+// fraction can be more than a sample. Both parts are kept apart so long
+// delays keep their precision in float. A kernel reads up to reach samples
+// older than the whole delay and lookahead samples newer,
+// which the delay line length and the feedback block size have to allow for.
+// Line is a DelayLine or its CompactView, whichever the line is read through.
+// Delays shorter than lookahead are read without it, less accurately.
+enum class Interpolation
+{
+    none,
+    linear,
+    cubic,
+    allpass
+};
+
+template <typename SampleType, Interpolation kernel>
+struct Interpolator;
+
+// Truncates to the whole sample, as taps did before they could interpolate
+template <typename SampleType>
+struct Interpolator<SampleType, Interpolation::none>
+{
+    static constexpr int reach = 0;
+    static constexpr int lookahead = 0;
+
+    template <typename Line>
+    static inline SampleType read(const Line& line, int channel, int position, int time,
+        SampleType delay, SampleType&)
+    {
+        return *line.getReadPointer(channel, position - time - static_cast<int>(delay));
+    }
+};
+
+template <typename SampleType>
+struct Interpolator<SampleType, Interpolation::linear>
+{
+    static constexpr int reach = 1;
+    static constexpr int lookahead = 0;
+
+    template <typename Line>
+    static inline SampleType read(const Line& line, int channel, int position, int time,
+        SampleType delay, SampleType&)
+    {
+        auto whole = static_cast<int>(delay);
+        auto fraction = delay - static_cast<SampleType>(whole);
+        auto older = line.getReadPointer(channel, position - time - whole - 1);
+        return older[1] + fraction * (older[0] - older[1]);
+    }
+};
+
+// Third-order Lagrange over the two samples either side of the read
+template <typename SampleType>
+struct Interpolator<SampleType, Interpolation::cubic>
+{
+    static constexpr int reach = 2;
+    static constexpr int lookahead = 1;
+
+    template <typename Line>
+    static inline SampleType read(const Line& line, int channel, int position, int time,
+        SampleType delay, SampleType&)
+    {
+        // x[3] is newest samples back, one short of the whole delay, and x[0]
+        // three further back; d is the read's distance back from x[3]
+        auto whole = static_cast<int>(delay);
+        auto step = time + whole > 0 ? 1 : 0;
+        auto d = delay - static_cast<SampleType>(whole - step);
+        auto x = line.getReadPointer(channel, position - time - whole + step - 3);
+
+        auto d1 = d - SampleType(1);
+        auto d2 = d - SampleType(2);
+        auto d3 = d - SampleType(3);
+
+        auto c0 = -d1 * d2 * d3 / SampleType(6);
+        auto c1 = d * d2 * d3 / SampleType(2);
+        auto c2 = -d * d1 * d3 / SampleType(2);
+        auto c3 = d * d1 * d2 / SampleType(6);
+
+        return c0 * x[3] + c1 * x[2] + c2 * x[1] + c3 * x[0];
+    }
+};
+
+// First-order Thiran allpass. Flat in level at every frequency but
+// recursive, so state carries its last output. Fractions are kept between
+// 0.618 and 1.618 where possible, where the allpass is best behaved.
+template <typename SampleType>
+struct Interpolator<SampleType, Interpolation::allpass>
+{
+    static constexpr int reach = 1;
+    static constexpr int lookahead = 1;
+
+    template <typename Line>
+    static inline SampleType read(const Line& line, int channel, int position, int time,
+        SampleType delay, SampleType& state)
+    {
+        auto whole = static_cast<int>(delay);
+        auto fraction = delay - static_cast<SampleType>(whole);
+
+        if (fraction < SampleType(0.618) && time + whole >= 1)
+        {
+            fraction += SampleType(1);
+            --whole;
+        }
+
+        auto alpha = (SampleType(1) - fraction) / (SampleType(1) + fraction);
+        auto older = line.getReadPointer(channel, position - time - whole - 1);
+
+        state = older[0] + alpha * (older[1] - state);
+        return state;
+    }
+};
+
+static_assert(Interpolator<float, Interpolation::cubic>::reach + Interpolator<float, Interpolation::cubic>::lookahead + 1
+    <= DelayLine<float>::kernel_span, "the delay line guard is too short for the cubic kernel");
+
+// @return - Samples past the whole delay the kernel reads
+inline int getInterpolationReach(Interpolation kernel)
+{
+    switch (kernel)
+    {
+        case Interpolation::linear:  return Interpolator<float, Interpolation::linear>::reach;
+        case Interpolation::cubic:   return Interpolator<float, Interpolation::cubic>::reach;
+        case Interpolation::allpass: return Interpolator<float, Interpolation::allpass>::reach;
+        default:                     return Interpolator<float, Interpolation::none>::reach;
+    }
+}
+
+// @return - Samples newer than the whole delay the kernel reads
+inline int getInterpolationLookahead(Interpolation kernel)
+{
+    switch (kernel)
+    {
+        case Interpolation::linear:  return Interpolator<float, Interpolation::linear>::lookahead;
+        case Interpolation::cubic:   return Interpolator<float, Interpolation::cubic>::lookahead;
+        case Interpolation::allpass: return Interpolator<float, Interpolation::allpass>::lookahead;
+        default:                     return Interpolator<float, Interpolation::none>::lookahead;
+    }
+}
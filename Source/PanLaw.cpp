@@ -0,0 +1,128 @@
+#include "PanLaw.h"
+
+//==============================================================================
+// Filled during static initialisation, long before the audio thread runs.
+// The extra entry lets getGain read table[index + 1] at position 1.
+struct PanLawTable
+{
+    PanLawTable()
+    {
+        for (int i = 0; i <= PanLaw::table_size; ++i)
+            values[i] = static_cast<float>(std::sin(0.5 * juce::MathConstants<double>::pi
+                * static_cast<double>(i) / PanLaw::table_size));
+
+        values[PanLaw::table_size + 1] = values[PanLaw::table_size];
+    }
+
+    float values [PanLaw::table_size + 2];
+};
+
+static const PanLawTable panLawTable;
+
+//==============================================================================
+float PanLaw::getGain(float position)
+{
+    auto scaled = juce::jlimit(0.0f, 1.0f, position) * static_cast<float>(table_size);
+    auto index = static_cast<int>(scaled);
+    auto fraction = scaled - static_cast<float>(index);
+
+    auto* values = panLawTable.values;
+    return values[index] + fraction * (values[index + 1] - values[index]);
+}
+
+//==============================================================================
+void ChannelPanner::setLayout(const juce::AudioChannelSet& layout)
+{
+    numChannels = juce::jmin(layout.size(), static_cast<int>(max_channels));
+    numSpeakers = 0;
+
+    float azimuth [max_channels] = { 0 };
+    auto isPositioned = true;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto type = layout.getTypeOfChannel(channel);
+
+        if (type == juce::AudioChannelSet::LFE || type == juce::AudioChannelSet::LFE2)
+            continue;
+
+        isPositioned = getAzimuth(type, azimuth[channel]) && isPositioned;
+        sweep[numSpeakers++] = channel;
+    }
+
+    // A mono input stays where stereo would image it. Layouts without a
+    // centre or a front pair take their first two channels instead
+    auto centre = layout.getChannelIndexForType(juce::AudioChannelSet::centre);
+    auto left = layout.getChannelIndexForType(juce::AudioChannelSet::left);
+    auto right = layout.getChannelIndexForType(juce::AudioChannelSet::right);
+
+    std::fill(std::begin(dryGains), std::end(dryGains), 0.0f);
+
+    if (juce::isPositiveAndBelow(centre, numChannels))
+        dryGains[centre] = 1.0f;
+    else if (juce::isPositiveAndBelow(left, numChannels) && juce::isPositiveAndBelow(right, numChannels))
+        dryGains[left] = dryGains[right] = 1.0f;
+    else
+        std::fill(dryGains, dryGains + juce::jmin(numChannels, 2), 1.0f);
+
+    // Speakers at the same azimuth, such as a height above its ear-level
+    // speaker, keep their channel order
+    if (isPositioned)
+        std::stable_sort(sweep, sweep + numSpeakers, [&azimuth] (int a, int b) { return azimuth[a] < azimuth[b]; });
+}
+
+void ChannelPanner::getGains(float pan, float gain, float* gains) const
+{
+    std::fill(gains, gains + numChannels, 0.0f);
+
+    if (numSpeakers == 0 || gain <= 0.0f)
+        return;
+
+    if (numSpeakers == 1)
+    {
+        gains[sweep[0]] = gain;
+        return;
+    }
+
+    auto position = pan * static_cast<float>(numSpeakers - 1);
+    auto pair = juce::jlimit(0, numSpeakers - 2, static_cast<int>(position));
+    auto fraction = position - static_cast<float>(pair);
+
+    gains[sweep[pair]] = PanLaw::getGain(1.0f - fraction) * gain;
+    gains[sweep[pair + 1]] = PanLaw::getGain(fraction) * gain;
+}
+
+// Degrees from the front, negative to the left. The rear centre sits at the
+// end of the sweep.
+bool ChannelPanner::getAzimuth(juce::AudioChannelSet::ChannelType type, float& degrees)
+{
+    using Set = juce::AudioChannelSet;
+
+    switch (type)
+    {
+        case Set::leftSurroundRear:  degrees = -150.0f; return true;
+        case Set::topRearLeft:       degrees = -135.0f; return true;
+        case Set::leftSurround:      degrees = -110.0f; return true;
+        case Set::leftSurroundSide:  degrees = -90.0f;  return true;
+        case Set::topSideLeft:       degrees = -90.0f;  return true;
+        case Set::wideLeft:          degrees = -60.0f;  return true;
+        case Set::topFrontLeft:      degrees = -45.0f;  return true;
+        case Set::left:              degrees = -30.0f;  return true;
+        case Set::leftCentre:        degrees = -15.0f;  return true;
+        case Set::centre:            degrees = 0.0f;    return true;
+        case Set::topFrontCentre:    degrees = 0.0f;    return true;
+        case Set::topMiddle:         degrees = 0.0f;    return true;
+        case Set::rightCentre:       degrees = 15.0f;   return true;
+        case Set::right:             degrees = 30.0f;   return true;
+        case Set::topFrontRight:     degrees = 45.0f;   return true;
+        case Set::wideRight:         degrees = 60.0f;   return true;
+        case Set::rightSurroundSide: degrees = 90.0f;   return true;
+        case Set::topSideRight:      degrees = 90.0f;   return true;
+        case Set::rightSurround:     degrees = 110.0f;  return true;
+        case Set::topRearRight:      degrees = 135.0f;  return true;
+        case Set::rightSurroundRear: degrees = 150.0f;  return true;
+        case Set::centreSurround:    degrees = 180.0f;  return true;
+        case Set::topRearCentre:     degrees = 180.0f;  return true;
+        default:                     return false;
+    }
+}
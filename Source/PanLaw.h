@@ -0,0 +1,66 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Equal-power pan law, sin(0.5 * pi * position), sampled once into a table and
+// linearly interpolated. The end points are exact, so hard-panned taps still
+// get gains of exactly 0 and 1.
+// https://forum.cockos.com/showthread.php?t=49809
+class PanLaw
+{
+public:
+    //==========================================================================
+    static constexpr int table_size = 4096;
+
+    // @param position - 0 (silent) to 1 (full gain)
+    static float getGain(float position);
+
+    // @param pan - 0 (left) to 1 (right)
+    static inline void getGains(float pan, float& left, float& right)
+    {
+        left = getGain(1.0f - pan);
+        right = getGain(pan);
+    }
+};
+
+//==============================================================================
+// Pans a tap across every speaker of an output layout. Speakers are swept by
+// azimuth from rear left, through the front, to rear right, and a position
+// between two neighbours is split with the equal-power law, so stereo pans
+// exactly as PanLaw::getGains does. LFE channels are never fed. Layouts
+// without speaker positions, such as discrete channels, are swept in channel
+// order.
+class ChannelPanner
+{
+public:
+    //==========================================================================
+    static constexpr int max_channels = 16;
+
+    // Not real-time safe
+    void setLayout(const juce::AudioChannelSet& layout);
+
+    inline int getNumChannels() const { return numChannels; }
+
+    // @param pan - 0 (start of the sweep) to 1 (end of the sweep)
+    // @param gain - Overall gain of the tap
+    // @param gains - One gain per channel, at most two of them non-zero
+    void getGains(float pan, float gain, float* gains) const;
+
+    // @return - Gain of a mono input's dry signal on channel, 1 on the centre
+    // speaker, or on the front pair of a layout without one, and 0 elsewhere
+    inline float getDryGain(int channel) const { return dryGains[channel]; }
+
+private:
+    //==========================================================================
+    // @return - False for channel types without a known position
+    static bool getAzimuth(juce::AudioChannelSet::ChannelType type, float& degrees);
+
+    int numChannels{ 0 };
+    int numSpeakers{ 0 };
+
+    // Channel index of every fed speaker, in sweep order
+    int sweep [max_channels] = { 0 };
+
+    float dryGains [max_channels] = { 0 };
+};
@@ -0,0 +1,80 @@
+#include "PeakFifo.h"
+
+//==============================================================================
+PeakFifo::PeakFifo()
+{
+    frames.allocate(static_cast<size_t>(capacity), true);
+}
+
+void PeakFifo::prepare(int newNumChannels, int newSamplesPerFrame)
+{
+    numChannels = juce::jmin(newNumChannels, static_cast<int>(PeakFrame::max_channels));
+    samplesPerFrame = juce::jmax(newSamplesPerFrame, 1);
+    partialSamples = 0;
+}
+
+//==============================================================================
+template <typename SampleType>
+void PeakFifo::push(const juce::AudioBuffer<SampleType>& buffer, int numSamples)
+{
+    if (!active.load())
+        return;
+
+    auto channels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    for (int start = 0; start < numSamples;)
+    {
+        auto count = juce::jmin(samplesPerFrame - partialSamples, numSamples - start);
+
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(channel, start), count);
+
+            if (partialSamples == 0)
+            {
+                partial.min[channel] = static_cast<float>(range.getStart());
+                partial.max[channel] = static_cast<float>(range.getEnd());
+            }
+            else
+            {
+                partial.min[channel] = juce::jmin(partial.min[channel], static_cast<float>(range.getStart()));
+                partial.max[channel] = juce::jmax(partial.max[channel], static_cast<float>(range.getEnd()));
+            }
+        }
+
+        start += count;
+        partialSamples += count;
+
+        if (partialSamples == samplesPerFrame)
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+            if (size1 > 0)
+            {
+                frames[start1] = partial;
+                fifo.finishedWrite(1);
+            }
+
+            partialSamples = 0;
+        }
+    }
+}
+
+template void PeakFifo::push(const juce::AudioBuffer<float>&, int);
+template void PeakFifo::push(const juce::AudioBuffer<double>&, int);
+
+int PeakFifo::pop(PeakFrame* dest, int maxFrames)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(maxFrames, start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i)
+        dest[i] = frames[start1 + i];
+
+    for (int i = 0; i < size2; ++i)
+        dest[size1 + i] = frames[start2 + i];
+
+    fifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
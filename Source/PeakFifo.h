@@ -0,0 +1,59 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Smallest and largest sample of every channel over one decimated frame
+struct PeakFrame
+{
+    static constexpr int max_channels = 16;
+
+    float min [max_channels];
+    float max [max_channels];
+};
+
+//==============================================================================
+// Wait-free single producer, single consumer queue of PeakFrames for the
+// editor's waveform. The audio thread reduces each block to min/max frames
+// and pushes them only while an editor is attached; the editor pops them on
+// its own timer. Frames that do not fit are dropped.
+class PeakFifo
+{
+public:
+    //==========================================================================
+    PeakFifo();
+
+    // Not thread safe, call while the audio thread is stopped
+    void prepare(int numChannels, int samplesPerFrame);
+
+    // Set by the editor for as long as it is open
+    inline void setActive(bool shouldBeActive) { active = shouldBeActive; }
+    inline bool isActive() const { return active.load(); }
+
+    inline int getNumChannels() const { return numChannels; }
+
+    //==========================================================================
+    // Audio thread, for float or double buffers
+    template <typename SampleType>
+    void push(const juce::AudioBuffer<SampleType>& buffer, int numSamples);
+
+    // Editor thread
+    // @return - Number of frames written to dest
+    int pop(PeakFrame* dest, int maxFrames);
+
+private:
+    //==========================================================================
+    static constexpr int capacity = 1024;
+
+    juce::AbstractFifo fifo{ capacity };
+    juce::HeapBlock<PeakFrame> frames;
+
+    std::atomic<bool> active{ false };
+
+    int numChannels{ 0 };
+    int samplesPerFrame{ 1 };
+
+    // Frame being accumulated across blocks
+    PeakFrame partial;
+    int partialSamples{ 0 };
+};
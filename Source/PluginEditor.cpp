@@ -123,71 +123,305 @@ timeDisplay::timeDisplay()
     setRange(0.0, 4000.0);
 }
 
+//==============================================================================
+peakDisplay::peakDisplay(PeakFifo& f) : fifo(f)
+{
+    for (auto& frame : history)
+    {
+        std::fill(frame.min, frame.min + PeakFrame::max_channels, 0.0f);
+        std::fill(frame.max, frame.max + PeakFrame::max_channels, 0.0f);
+    }
+
+    // Frames left over from a previous editor are stale
+    while (fifo.pop(incoming, history_size) > 0) {}
+
+    fifo.setActive(true);
+    startTimerHz(idle_rate_hz);
+}
+
+peakDisplay::~peakDisplay()
+{
+    fifo.setActive(false);
+}
+
+void peakDisplay::setRate(int rateHz)
+{
+    if (getTimerInterval() != 1000 / rateHz)
+        startTimerHz(rateHz);
+}
+
+void peakDisplay::timerCallback()
+{
+    auto numFrames = fifo.pop(incoming, history_size);
+
+    if (numFrames == 0)
+    {
+        setRate(idle_rate_hz);
+        return;
+    }
+
+    auto wasVisible = framesSinceSignal < history_size;
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        auto& frame = incoming[i];
+        auto isSilent = true;
+
+        for (int channel = 0; channel < fifo.getNumChannels(); ++channel)
+            isSilent = isSilent && std::abs(frame.min[channel]) < silence_level
+                                && std::abs(frame.max[channel]) < silence_level;
+
+        framesSinceSignal = isSilent ? juce::jmin(framesSinceSignal + 1, history_size) : 0;
+
+        history[historyStart] = frame;
+        historyStart = (historyStart + 1) % history_size;
+    }
+
+    // Once the last signal has scrolled off, the flat line is already drawn
+    if (framesSinceSignal < history_size)
+    {
+        setRate(active_rate_hz);
+        repaint();
+    }
+    else
+    {
+        setRate(idle_rate_hz);
+
+        if (wasVisible)
+            repaint();
+    }
+}
+
+// Draws each channel in its own band, as juce::AudioVisualiserComponent does
+void peakDisplay::paint(Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+    g.setColour(juce::Colours::white);
+
+    auto numChannels = juce::jmax(fifo.getNumChannels(), 1);
+    auto bandHeight = static_cast<float>(getHeight()) / static_cast<float>(numChannels);
+    auto xScale = static_cast<float>(getWidth()) / static_cast<float>(history_size);
+
+    for (int channel = 0; channel < fifo.getNumChannels(); ++channel)
+    {
+        juce::Path path;
+        path.preallocateSpace(4 * history_size + 8);
+
+        for (int i = 0; i < history_size; ++i)
+        {
+            auto& frame = history[(historyStart + i) % history_size];
+
+            if (i == 0)
+                path.startNewSubPath(0.0f, -frame.max[channel]);
+            else
+                path.lineTo(static_cast<float>(i), -frame.max[channel]);
+        }
+
+        for (int i = history_size - 1; i >= 0; --i)
+            path.lineTo(static_cast<float>(i), -history[(historyStart + i) % history_size].min[channel]);
+
+        path.closeSubPath();
+
+        auto centreY = bandHeight * (static_cast<float>(channel) + 0.5f);
+        g.fillPath(path, juce::AffineTransform::scale(xScale, bandHeight * 0.5f).translated(0.0f, centreY));
+    }
+}
+
+#if SEQUENCEDDELAY_PROFILE
+//==============================================================================
+profileOverlay::profileOverlay(Profiler& p) : profiler(p)
+{
+    dump.onClick = [this] { dumpToJson(); };
+    addAndMakeVisible(dump);
+
+    startTimerHz(4);
+}
+
+void profileOverlay::timerCallback()
+{
+    double busySeconds = 0.0, callbackSeconds = 0.0;
+    int numRecords;
+
+    while ((numRecords = profiler.popRecords(incoming, recent_size)) > 0)
+    {
+        for (int i = 0; i < numRecords; ++i)
+        {
+            auto& r = incoming[i];
+
+            if (r.section == Profiler::process_block && r.sampleRate > 0.0f)
+            {
+                busySeconds += r.microseconds * 1.0e-6;
+                callbackSeconds += r.numSamples / r.sampleRate;
+            }
+
+            recent[(recentStart + numRecent) % recent_size] = r;
+
+            if (numRecent < recent_size)
+                ++numRecent;
+            else
+                recentStart = (recentStart + 1) % recent_size;
+        }
+    }
+
+    if (callbackSeconds > 0.0)
+        load = busySeconds / callbackSeconds;
+
+    repaint();
+}
+
+void profileOverlay::paint(Graphics& g)
+{
+    g.fillAll(juce::Colours::black.withAlpha(0.7f));
+    g.setColour(juce::Colours::white);
+    g.setFont(11.0f);
+
+    g.drawText("DSP load " + juce::String(load * 100.0, 2) + "%", 4, 2, getWidth() - 8, 14,
+        juce::Justification::left);
+
+    for (int s = 0; s < Profiler::num_sections; ++s)
+    {
+        auto line = juce::String(Profiler::getSectionName(s)) + "  p50 "
+            + juce::String(profiler.getPercentile(s, 0.5), 1) + " us  p99 "
+            + juce::String(profiler.getPercentile(s, 0.99), 1) + " us";
+
+        g.drawText(line, 4, 16 + 14 * s, getWidth() - 8, 14, juce::Justification::left);
+    }
+}
+
+void profileOverlay::resized()
+{
+    dump.setBounds(getWidth() - 84, 2, 80, 18);
+}
+
+void profileOverlay::dumpToJson()
+{
+    chooser = std::make_unique<juce::FileChooser>("Save profile",
+        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("SequencedDelayProfile.json"),
+        "*.json");
+
+    chooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::warnAboutOverwriting,
+        [this](const juce::FileChooser& fc)
+        {
+            auto file = fc.getResult();
+
+            if (file == juce::File())
+                return;
+
+            // Unwrap the ring so the dump is in time order
+            juce::HeapBlock<ProfileRecord> ordered(static_cast<size_t>(numRecent));
+
+            for (int i = 0; i < numRecent; ++i)
+                ordered[i] = recent[(recentStart + i) % recent_size];
+
+            file.replaceWithText(juce::JSON::toString(profiler.toJson(ordered.get(), numRecent)));
+        });
+}
+#endif
+
 //==============================================================================
 SequencedDelayEditor::SequencedDelayEditor
 (SequencedDelay& p, juce::AudioProcessorValueTreeState& vts)
-    : AudioProcessorEditor(&p), valueTreeState(vts)
+    : AudioProcessorEditor(&p), valueTreeState(vts), peaks(p.peaks)
+   #if SEQUENCEDDELAY_PROFILE
+    , profile(p.profiler)
+   #endif
 {
-    viz = &p.viz;
-
     setLookAndFeel(&look);
     setSize (800, 600);
 
-    viz->setColours(Colour(0.0f, 0.0f, 0.0f), Colour(1.0f, 1.0f, 1.0f));
-    viz->setRepaintRate(60);
-    addAndMakeVisible(viz);
+    addAndMakeVisible(peaks);
     
     for (int i = 0; i < num_delays; ++i)
     {
-        auto numStr = std::to_string(i + 1);
-        auto colour = rainbow[i % 7];
-
-        select.addItem(numStr, i + 1);
+        select.addItem(std::to_string(i + 1), i + 1);
 
-        time[i].setColour(juce::Slider::ColourIds::thumbColourId, colour);
+        time[i].setColour(juce::Slider::ColourIds::thumbColourId, rainbow[i % 7]);
         time[i].setLookAndFeel(&look);
         addAndMakeVisible(&time[i]);
-
-        sync[i].setColour(juce::ToggleButton::ColourIds::tickColourId, colour);
-        addAndMakeVisible(&sync[i]);
-        syncAttach[i].reset(new ButtonAttachment(valueTreeState, "sync" + numStr, sync[i]));
-        sync[i].onClick = [this] { syncChanged(); };
-
-        delay[i].setSliderStyle(juce::Slider::LinearBar);
-        delay[i].setColour(juce::Slider::ColourIds::trackColourId, colour);
-        delay[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
-        delay[i].setTextValueSuffix(" ms");
-        delay[i].setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
-        delay[i].setLookAndFeel(&look);
-        addAndMakeVisible(&delay[i]);
-        delayAttach[i].reset(new SliderAttachment(valueTreeState, "delay" + numStr, delay[i]));
-
-        sixt[i].setSliderStyle(juce::Slider::LinearBar);
-        sixt[i].setColour(juce::Slider::ColourIds::trackColourId, colour);
-        sixt[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
-        sixt[i].setTextValueSuffix("/16");
-        sixt[i].setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
-        sixt[i].setLookAndFeel(&look);
-        addAndMakeVisible(&sixt[i]);
-        sixtAttach[i].reset(new SliderAttachment(valueTreeState, "sixt" + numStr, sixt[i]));
-
-        gain[i].setSliderStyle(juce::Slider::LinearBar);
-        gain[i].setColour(juce::Slider::ColourIds::trackColourId, colour);
-        gain[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
-        gain[i].setTextValueSuffix("%");
-        gain[i].setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
-        gain[i].setLookAndFeel(&look);
-        addAndMakeVisible(&gain[i]);
-        feedbackAttach[i].reset(new SliderAttachment(valueTreeState, "gain" + numStr, gain[i]));
-
-        pan[i].setSliderStyle(juce::Slider::Rotary);
-        pan[i].setColour(juce::Slider::ColourIds::thumbColourId, colour);
-        pan[i].setTextBoxStyle(juce::Slider::NoTextBox, false, 60, 30);
-        pan[i].setTextValueSuffix("%");
-        addAndMakeVisible(&pan[i]);
-        panAttach[i].reset(new SliderAttachment(valueTreeState, "pan" + numStr, pan[i]));
     }
 
+    // Colours and attachments are set per tap in selectChanged
+    addAndMakeVisible(&sync);
+    sync.onClick = [this] { syncChanged(); };
+
+    delay.setSliderStyle(juce::Slider::LinearBar);
+    delay.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
+    delay.setTextValueSuffix(" ms");
+    delay.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
+    delay.setLookAndFeel(&look);
+    addAndMakeVisible(&delay);
+
+    sixt.setSliderStyle(juce::Slider::LinearBar);
+    sixt.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
+    sixt.setTextValueSuffix("/16");
+    sixt.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
+    sixt.setLookAndFeel(&look);
+    addAndMakeVisible(&sixt);
+
+    gain.setSliderStyle(juce::Slider::LinearBar);
+    gain.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
+    gain.setTextValueSuffix("%");
+    gain.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
+    gain.setLookAndFeel(&look);
+    addAndMakeVisible(&gain);
+
+    pan.setSliderStyle(juce::Slider::Rotary);
+    pan.setTextBoxStyle(juce::Slider::NoTextBox, false, 60, 30);
+    pan.setTextValueSuffix("%");
+    addAndMakeVisible(&pan);
+
+    feedback.setSliderStyle(juce::Slider::LinearBar);
+    feedback.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
+    feedback.setTextValueSuffix("%");
+    feedback.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
+    feedback.setLookAndFeel(&look);
+    addAndMakeVisible(&feedback);
+
+    highPass.setSliderStyle(juce::Slider::LinearBar);
+    highPass.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
+    highPass.setTextValueSuffix(" Hz");
+    highPass.setNumDecimalPlacesToDisplay(0);
+    highPass.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
+    highPass.setLookAndFeel(&look);
+    addAndMakeVisible(&highPass);
+
+    lowPass.setSliderStyle(juce::Slider::LinearBar);
+    lowPass.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
+    lowPass.setTextValueSuffix(" Hz");
+    lowPass.setNumDecimalPlacesToDisplay(0);
+    lowPass.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
+    lowPass.setLookAndFeel(&look);
+    addAndMakeVisible(&lowPass);
+
+    rate.setSliderStyle(juce::Slider::LinearBar);
+    rate.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
+    rate.setTextValueSuffix(" Hz");
+    rate.setNumDecimalPlacesToDisplay(2);
+    rate.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
+    rate.setLookAndFeel(&look);
+    addAndMakeVisible(&rate);
+
+    depth.setSliderStyle(juce::Slider::LinearBar);
+    depth.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
+    depth.setTextValueSuffix(" ms");
+    depth.setNumDecimalPlacesToDisplay(1);
+    depth.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
+    depth.setLookAndFeel(&look);
+    addAndMakeVisible(&depth);
+
+    panDepth.setSliderStyle(juce::Slider::LinearBar);
+    panDepth.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
+    panDepth.setTextValueSuffix("%");
+    panDepth.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
+    panDepth.setLookAndFeel(&look);
+    addAndMakeVisible(&panDepth);
+
+    // Items first, the attachment made in selectChanged selects the current one
+    interpolation.addItemList({ "None", "Linear", "Cubic", "Allpass" }, 1);
+    interpolation.setColour(juce::ComboBox::ColourIds::backgroundColourId, juce::Colours::black.withAlpha(0.5f));
+    interpolation.setColour(juce::ComboBox::ColourIds::outlineColourId, juce::Colours::white.withAlpha(0.5f));
+    addAndMakeVisible(interpolation);
+
     select.setColour(juce::ComboBox::ColourIds::backgroundColourId, juce::Colours::black.withAlpha(0.5f));
     select.setColour(juce::ComboBox::ColourIds::outlineColourId, juce::Colours::white.withAlpha(0.5f));
     select.setScrollWheelEnabled(true);
@@ -204,15 +438,63 @@ SequencedDelayEditor::SequencedDelayEditor
     blend.setTextValueSuffix("%");
     blendAttach.reset(new SliderAttachment(valueTreeState, "blend", blend));
     addAndMakeVisible(blend);
+
+    // Items first, the attachment selects the current one
+    timeMode.addItemList({ "Ramp", "Crossfade" }, 1);
+    timeMode.setColour(juce::ComboBox::ColourIds::backgroundColourId, juce::Colours::black.withAlpha(0.5f));
+    timeMode.setColour(juce::ComboBox::ColourIds::outlineColourId, juce::Colours::white.withAlpha(0.5f));
+    timeModeAttach.reset(new ComboBoxAttachment(valueTreeState, "timeMode", timeMode));
+    addAndMakeVisible(timeMode);
+
+    cross.setSliderStyle(juce::Slider::LinearBar);
+    cross.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 200, 30);
+    cross.setTextValueSuffix("%");
+    cross.setColour(juce::Slider::ColourIds::trackColourId, juce::Colours::white.withAlpha(0.5f));
+    cross.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, juce::Colours::white.withAlpha(0.5f));
+    cross.setLookAndFeel(&look);
+    crossAttach.reset(new SliderAttachment(valueTreeState, "cross", cross));
+    addAndMakeVisible(cross);
+
+    longDelay.setColour(juce::ToggleButton::ColourIds::tickColourId, juce::Colours::white);
+    longDelayAttach.reset(new ButtonAttachment(valueTreeState, "longDelay", longDelay));
+    addAndMakeVisible(longDelay);
+    valueTreeState.addParameterListener("longDelay", this);
+    longDelayChanged();
+
+   #if SEQUENCEDDELAY_PROFILE
+    addAndMakeVisible(profile);
+   #endif
 }
 
 SequencedDelayEditor::~SequencedDelayEditor()
 {
+    valueTreeState.removeParameterListener("longDelay", this);
+    cancelPendingUpdate();
+
     setLookAndFeel(nullptr);
 }
 
 //==============================================================================
 void SequencedDelayEditor::paint (juce::Graphics& g)
+{
+    // Only redraw the static layer when the pixel scale changes
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (background.isNull() || scale != backgroundScale)
+    {
+        backgroundScale = scale;
+        background = juce::Image(juce::Image::RGB, juce::roundToInt(getWidth() * scale),
+            juce::roundToInt(getHeight() * scale), false);
+
+        juce::Graphics imageGraphics(background);
+        imageGraphics.addTransform(juce::AffineTransform::scale(scale));
+        drawBackground(imageGraphics);
+    }
+
+    g.drawImage(background, getLocalBounds().toFloat());
+}
+
+void SequencedDelayEditor::drawBackground(juce::Graphics& g)
 {
     // Fill whole window
     g.fillAll (juce::Colour(0xff202020));
@@ -230,55 +512,139 @@ void SequencedDelayEditor::paint (juce::Graphics& g)
     g.drawFittedText("Delay Time", 150, a, 245, 20, juce::Justification::centred, 1);
     g.drawFittedText("Gain", 405, a, 245, 20, juce::Justification::centred, 1);
     g.drawFittedText("Pan", 660, a, 40, 20, juce::Justification::centred, 1);
+    g.drawFittedText("Time Change", 550, a + 30, 120, 20, juce::Justification::centred, 1);
+    g.drawFittedText("Feedback", 150, a + 30, 180, 20, juce::Justification::centred, 1);
+    g.drawFittedText("Ping-Pong", 550, a + 100, 120, 20, juce::Justification::centred, 1);
+    g.drawFittedText("High-pass", 150, a + 100, 85, 20, juce::Justification::centred, 1);
+    g.drawFittedText("Low-pass", 245, a + 100, 85, 20, juce::Justification::centred, 1);
+    g.drawFittedText("LFO Rate", 150, a + 170, 85, 20, juce::Justification::centred, 1);
+    g.drawFittedText("LFO Depth", 245, a + 170, 85, 20, juce::Justification::centred, 1);
+    g.drawFittedText("Pan LFO", 550, a + 170, 120, 20, juce::Justification::centred, 1);
+    g.drawFittedText("Interpolation", 680, a + 30, 100, 20, juce::Justification::centred, 1);
+    g.drawFittedText("Long Delay", 680, a + 100, 100, 20, juce::Justification::centred, 1);
 }
 
 void SequencedDelayEditor::resized()
 {
     /// Called at initialization, and at resize if enabled
     // Set location of all components
-    viz->setBounds(100, 200, 600, 80);
+    peaks.setBounds(100, 200, 600, 80);
 
     const int a = 320;
     for (int i = 0; i < num_delays; ++i)
     {
         time[i].setBounds(100, 200, 600, 80);
-        sync[i].setBounds(100, a, 40, 40);
-        delay[i].setBounds(150, a, 245, 40);
-        sixt[i].setBounds(150, a, 245, 40);
-        gain[i].setBounds(405, a, 245, 40);
-        pan[i].setBounds(660, a, 40, 40);
     }
+
+    sync.setBounds(100, a, 40, 40);
+    delay.setBounds(150, a, 245, 40);
+    sixt.setBounds(150, a, 245, 40);
+    gain.setBounds(405, a, 245, 40);
+    pan.setBounds(660, a, 40, 40);
+
     blend.setBounds(350, a + 100, 100, 100);
     select.setBounds(350, a + 50, 100, 40);
+    timeMode.setBounds(550, a + 50, 120, 40);
+    feedback.setBounds(150, a + 50, 180, 40);
+    cross.setBounds(550, a + 120, 120, 40);
+    highPass.setBounds(150, a + 120, 85, 40);
+    lowPass.setBounds(245, a + 120, 85, 40);
+    rate.setBounds(150, a + 190, 85, 40);
+    depth.setBounds(245, a + 190, 85, 40);
+    panDepth.setBounds(550, a + 190, 120, 40);
+    interpolation.setBounds(680, a + 50, 100, 40);
+    longDelay.setBounds(710, a + 120, 40, 40);
+
+   #if SEQUENCEDDELAY_PROFILE
+    profile.setBounds(10, 10, 300, 76);
+   #endif
+
+    background = {};
 }
 
 void SequencedDelayEditor::syncChanged()
 {
-    for (int i = 0; i < num_delays; ++i)
-    {
-        if (i == select.getSelectedId() - 1)
-        {
-            bool on = sync[i].getToggleState();
-            delay[i].setVisible(!on);
-            sixt[i].setVisible(on);
-        }
-    }
+    bool on = sync.getToggleState();
+    delay.setVisible(!on);
+    sixt.setVisible(on);
 }
 
+// Points the single control set at the selected tap
 void SequencedDelayEditor::selectChanged()
 {
     int t = select.getSelectedId() - 1;
-    bool isSelected;
 
-    for (int i = 0; i < num_delays; ++i)
-    {
-        isSelected = t == i;
+    if (t < 0 || t == boundTap)
+        return;
+
+    boundTap = t;
+
+    auto numStr = std::to_string(t + 1);
+    auto colour = rainbow[t % 7];
+
+    // Detach from the previous tap first so its parameters are left alone
+    syncAttach.reset();
+    delayAttach.reset();
+    sixtAttach.reset();
+    gainAttach.reset();
+    panAttach.reset();
+    feedbackAttach.reset();
+    highPassAttach.reset();
+    lowPassAttach.reset();
+    rateAttach.reset();
+    depthAttach.reset();
+    panDepthAttach.reset();
+    interpolationAttach.reset();
+
+    sync.setColour(juce::ToggleButton::ColourIds::tickColourId, colour);
+    delay.setColour(juce::Slider::ColourIds::trackColourId, colour);
+    sixt.setColour(juce::Slider::ColourIds::trackColourId, colour);
+    gain.setColour(juce::Slider::ColourIds::trackColourId, colour);
+    pan.setColour(juce::Slider::ColourIds::thumbColourId, colour);
+    feedback.setColour(juce::Slider::ColourIds::trackColourId, colour);
+    highPass.setColour(juce::Slider::ColourIds::trackColourId, colour);
+    lowPass.setColour(juce::Slider::ColourIds::trackColourId, colour);
+    rate.setColour(juce::Slider::ColourIds::trackColourId, colour);
+    depth.setColour(juce::Slider::ColourIds::trackColourId, colour);
+    panDepth.setColour(juce::Slider::ColourIds::trackColourId, colour);
+
+    syncAttach.reset(new ButtonAttachment(valueTreeState, "sync" + numStr, sync));
+    delayAttach.reset(new SliderAttachment(valueTreeState, "delay" + numStr, delay));
+    sixtAttach.reset(new SliderAttachment(valueTreeState, "sixt" + numStr, sixt));
+    gainAttach.reset(new SliderAttachment(valueTreeState, "gain" + numStr, gain));
+    panAttach.reset(new SliderAttachment(valueTreeState, "pan" + numStr, pan));
+    feedbackAttach.reset(new SliderAttachment(valueTreeState, "fdbk" + numStr, feedback));
+    highPassAttach.reset(new SliderAttachment(valueTreeState, "hpf" + numStr, highPass));
+    lowPassAttach.reset(new SliderAttachment(valueTreeState, "lpf" + numStr, lowPass));
+    rateAttach.reset(new SliderAttachment(valueTreeState, "rate" + numStr, rate));
+    depthAttach.reset(new SliderAttachment(valueTreeState, "depth" + numStr, depth));
+    panDepthAttach.reset(new SliderAttachment(valueTreeState, "panMod" + numStr, panDepth));
+    interpolationAttach.reset(new ComboBoxAttachment(valueTreeState, "interp" + numStr, interpolation));
+
+    syncChanged();
+    longDelayChanged();
+}
 
-        sync[i].setVisible(isSelected);
-        delay[i].setVisible(isSelected && !sync[i].getToggleState());
-        sixt[i].setVisible(isSelected && sync[i].getToggleState());
-        gain[i].setVisible(isSelected);
-        pan[i].setVisible(isSelected);
-    }
+// Shows Delay Time in the milliseconds it plays at, stretched in long delay
+// mode. Reads the parameter, which the button attachment may not have caught
+// up with yet.
+void SequencedDelayEditor::longDelayChanged()
+{
+    auto isLong = valueTreeState.getRawParameterValue("longDelay")->load() > 0.5f;
+    auto scale = isLong ? SequencedDelay::long_delay_time_scale : 1.0f;
+
+    // Set after the attachment, which installs the parameter's own text
+    delay.textFromValueFunction = [scale](double value) { return juce::String(juce::roundToInt(value * scale)); };
+    delay.valueFromTextFunction = [scale](const juce::String& text) { return text.getDoubleValue() / scale; };
+    delay.updateText();
 }
 
+void SequencedDelayEditor::parameterChanged(const juce::String&, float)
+{
+    triggerAsyncUpdate();
+}
+
+void SequencedDelayEditor::handleAsyncUpdate()
+{
+    longDelayChanged();
+}
@@ -13,6 +13,7 @@ using juce::ToggleButton;
 //==============================================================================
 typedef juce::AudioProcessorValueTreeState::SliderAttachment SliderAttachment;
 typedef juce::AudioProcessorValueTreeState::ButtonAttachment ButtonAttachment;
+typedef juce::AudioProcessorValueTreeState::ComboBoxAttachment ComboBoxAttachment;
 
 const Colour rainbow[7] = { Colour((uint8)255, (uint8)0, (uint8)0),
                             Colour((uint8)255, (uint8)127, (uint8)0),
@@ -61,7 +62,76 @@ private:
 };
 
 //==============================================================================
-class SequencedDelayEditor : public juce::AudioProcessorEditor
+// Scrolling min/max waveform drained from the processor's PeakFifo
+class peakDisplay : public juce::Component, private juce::Timer
+{
+public:
+    //==========================================================================
+    peakDisplay(PeakFifo& fifo);
+    ~peakDisplay() override;
+
+    void paint(Graphics& g) override;
+
+private:
+    //==========================================================================
+    void timerCallback() override;
+
+    static constexpr int history_size = 512;
+
+    // Redraws at active_rate_hz while any signal is on screen, otherwise
+    // polls at idle_rate_hz and skips repainting
+    static constexpr int active_rate_hz = 60;
+    static constexpr int idle_rate_hz = 10;
+    static constexpr float silence_level = 1.0e-4f;
+
+    void setRate(int rateHz);
+
+    PeakFifo& fifo;
+    PeakFrame history[history_size];
+    PeakFrame incoming[history_size];
+    int historyStart{ 0 };
+    int framesSinceSignal{ history_size };
+};
+
+#if SEQUENCEDDELAY_PROFILE
+//==============================================================================
+// Shows the profiler's timings and DSP load, and dumps them to JSON
+class profileOverlay : public juce::Component, private juce::Timer
+{
+public:
+    //==========================================================================
+    profileOverlay(Profiler& profiler);
+
+    void paint(Graphics& g) override;
+    void resized() override;
+
+private:
+    //==========================================================================
+    void timerCallback() override;
+    void dumpToJson();
+
+    static constexpr int recent_size = 1024;
+
+    Profiler& profiler;
+
+    // The newest records, oldest first once the ring has wrapped
+    ProfileRecord recent[recent_size];
+    ProfileRecord incoming[recent_size];
+    int recentStart{ 0 };
+    int numRecent{ 0 };
+
+    // processBlock time over callback time since the last update
+    double load{ 0.0 };
+
+    juce::TextButton dump{ "Dump JSON" };
+    std::unique_ptr<juce::FileChooser> chooser;
+};
+#endif
+
+//==============================================================================
+class SequencedDelayEditor : public juce::AudioProcessorEditor,
+                             private juce::AudioProcessorValueTreeState::Listener,
+                             private juce::AsyncUpdater
 {
 public:
     SequencedDelayEditor(SequencedDelay& p,
@@ -75,8 +145,15 @@ public:
     //==========================================================================
     void syncChanged();
     void selectChanged();
+    void longDelayChanged();
 
 private:
+    //==========================================================================
+    // Long delay mode can change from automation, a loaded state or a
+    // program as well as a click, on any thread
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+
     //==========================================================================
     customLook look;
 
@@ -85,23 +162,58 @@ private:
 
     juce::ComboBox select;
 
-    juce::AudioVisualiserComponent* viz;
+    // Title and labels, drawn once at the display's pixel scale
+    void drawBackground(Graphics& g);
+    juce::Image background;
+    float backgroundScale{ 0.0f };
+
+    peakDisplay peaks;
     timeDisplay time[num_delays];
 
-    juce::ToggleButton sync[num_delays];
-    std::unique_ptr<ButtonAttachment> syncAttach[num_delays];
-    juce::Slider delay[num_delays];
-    std::unique_ptr<SliderAttachment> delayAttach[num_delays];
-    juce::Slider sixt[num_delays];
-    std::unique_ptr<SliderAttachment> sixtAttach[num_delays];
-    juce::Slider gain[num_delays];
-    std::unique_ptr<SliderAttachment> feedbackAttach[num_delays];
-    juce::Slider pan[num_delays];
-    std::unique_ptr<SliderAttachment> panAttach[num_delays];
+    // One set of tap controls, rebound to whichever tap is selected
+    int boundTap{ -1 };
+
+    juce::ToggleButton sync;
+    std::unique_ptr<ButtonAttachment> syncAttach;
+    juce::Slider delay;
+    std::unique_ptr<SliderAttachment> delayAttach;
+    juce::Slider sixt;
+    std::unique_ptr<SliderAttachment> sixtAttach;
+    juce::Slider gain;
+    std::unique_ptr<SliderAttachment> gainAttach;
+    juce::Slider pan;
+    std::unique_ptr<SliderAttachment> panAttach;
+    juce::Slider feedback;
+    std::unique_ptr<SliderAttachment> feedbackAttach;
+    juce::Slider highPass;
+    std::unique_ptr<SliderAttachment> highPassAttach;
+    juce::Slider lowPass;
+    std::unique_ptr<SliderAttachment> lowPassAttach;
+    juce::Slider rate;
+    std::unique_ptr<SliderAttachment> rateAttach;
+    juce::Slider depth;
+    std::unique_ptr<SliderAttachment> depthAttach;
+    juce::Slider panDepth;
+    std::unique_ptr<SliderAttachment> panDepthAttach;
+    juce::ComboBox interpolation;
+    std::unique_ptr<ComboBoxAttachment> interpolationAttach;
 
     juce::Slider blend;
     std::unique_ptr<SliderAttachment> blendAttach;
 
+    juce::ComboBox timeMode;
+    std::unique_ptr<ComboBoxAttachment> timeModeAttach;
+
+    juce::Slider cross;
+    std::unique_ptr<SliderAttachment> crossAttach;
+
+    juce::ToggleButton longDelay;
+    std::unique_ptr<ButtonAttachment> longDelayAttach;
+
+   #if SEQUENCEDDELAY_PROFILE
+    profileOverlay profile;
+   #endif
+
     //==========================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SequencedDelayEditor)
 };
\ No newline at end of file
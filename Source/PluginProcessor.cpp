@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "RealtimeCheck.h"
 
 //==============================================================================
 const juce::String SequencedDelay::getName() const
@@ -34,28 +35,87 @@ bool SequencedDelay::isMidiEffect() const
    #endif
 }
 
+// Longest audible tap, updated by processBlock
 double SequencedDelay::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailSeconds.load();
 }
 
 int SequencedDelay::getNumPrograms()
 {
-    return 1;
+    return programs.size();
 }
 
 int SequencedDelay::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load();
 }
 
+// Hands the whole program to the audio thread in one store, then brings the
+// parameters in line so the editor, the host and saved states agree with it.
+// Hosts often select the current program again on load, which must not
+// overwrite a restored state.
 void SequencedDelay::setCurrentProgram (int index)
 {
+    if (index < 0 || index >= programs.size() || index == currentProgram.load())
+        return;
+
+    currentProgram = index;
+
+    auto& program = programs[index];
+
+    loadingProgram = true;
+    pendingProgram = &program;
+
+    // Taps a program leaves at their defaults are usually at them already,
+    // so only parameters that actually move are sent to the host, each as
+    // one gesture so hosts that record automation take it as a single edit
+    auto setValue = [this] (const juce::String& parameterID, float value)
+    {
+        auto* parameter = parameters.getParameter(parameterID);
+
+        if (parameter == nullptr)
+            return;
+
+        auto normalised = parameter->convertTo0to1(value);
+
+        if (parameter->getValue() == normalised)
+            return;
+
+        parameter->beginChangeGesture();
+        parameter->setValueNotifyingHost(normalised);
+        parameter->endChangeGesture();
+    };
+
+    for (int i = 0; i < num_delays; ++i)
+    {
+        auto numStr = juce::String(i + 1);
+        auto& settings = program.taps[i];
+
+        setValue("delay" + numStr, settings.delay);
+        setValue("gain" + numStr, settings.gain);
+        setValue("pan" + numStr, settings.pan);
+        setValue("sync" + numStr, settings.sync ? 1.0f : 0.0f);
+        setValue("sixt" + numStr, settings.sixt);
+        setValue("fdbk" + numStr, settings.feedback);
+        setValue("lpf" + numStr, settings.lowPass);
+        setValue("hpf" + numStr, settings.highPass);
+        setValue("rate" + numStr, settings.rate);
+        setValue("depth" + numStr, settings.depth);
+        setValue("panMod" + numStr, settings.panDepth);
+        setValue("interp" + numStr, settings.interpolation);
+    }
+
+    loadingProgram = false;
+    updateHostDisplay();
 }
 
 const juce::String SequencedDelay::getProgramName (int index)
 {
-    return {};
+    if (index < 0 || index >= programs.size())
+        return {};
+
+    return programs[index].name;
 }
 
 void SequencedDelay::changeProgramName (int index, const juce::String& newName)
@@ -65,41 +125,163 @@ void SequencedDelay::changeProgramName (int index, const juce::String& newName)
 //==============================================================================
 void SequencedDelay::prepareToPlay(double sampleRate, int samplesPerBlock)
 {    
+    // Hosts switch to offline before preparing a bounce. Offline renders
+    // split the taps into one group per output channel, up to one per core,
+    // and only split host blocks larger than offline_block_size. Host blocks
+    // are not batched together, and grouping and piece size leave the output
+    // sample-identical.
+    auto isOffline = isNonRealtime();
+
+    // Every scratch buffer is sized here so processBlock never allocates;
+    // larger host blocks are split into pieces of maxBlockSize
+    maxBlockSize = juce::jmax(samplesPerBlock, isOffline ? offline_block_size : 1);
+
+    // Taps pan across the speakers of the output layout
+    auto outputChannels = getTotalNumOutputChannels();
+    auto layout = getChannelLayoutOfBus(false, 0);
+
+    if (layout.size() != outputChannels)
+        layout = juce::AudioChannelSet::canonicalChannelSet(outputChannels);
+
+    panner.setLayout(layout);
+
+    // One group is rendered on the audio thread, the rest on the workers
+    auto groupSize = isOffline ? 1 : channels_per_group;
+    auto numGroups = juce::jlimit(1, static_cast<int>(TapEngine<float>::max_groups),
+        juce::jmin(outputChannels / groupSize, juce::SystemStats::getNumCpus()));
+
+    workers.prepare(numGroups - 1, sampleRate, maxBlockSize);
+
+    // Only the precision the host will call processBlock with holds memory
+    if (getProcessingPrecision() == doublePrecision)
+    {
+        prepareState(doubleState, sampleRate, numGroups);
+        releaseState(floatState);
+    }
+    else
+    {
+        prepareState(floatState, sampleRate, numGroups);
+        releaseState(doubleState);
+    }
+
+    // The sample rate may have changed, so derive every tap again
+    settingsValid = false;
+
+    // Set up audio visualizer, one frame per 256 samples
+    peaks.prepare(getTotalNumOutputChannels(), 256);
+
+   #if SEQUENCEDDELAY_PROFILE
+    profiler.setSampleRate(sampleRate);
+   #endif
+}
+
+void SequencedDelay::releaseResources()
+{
+    floatState.delayResizer.release();
+    doubleState.delayResizer.release();
+    workers.release();
+}
+
+// Sizes every buffer of one precision's state
+template <typename SampleType>
+void SequencedDelay::prepareState(DspState<SampleType>& state, double sampleRate, int numGroups)
+{
     // Prepare smoothed values
+    for (auto& engine : state.tapSets)
+        engine.prepare(sampleRate, maxBlockSize, getTotalNumOutputChannels(), numGroups);
+    state.blendSmooth.reset(sampleRate, 0.02f);
+    state.blendRamp.setSize(2, maxBlockSize);
+    
+    // Size delayBuffer for the longest delay the current settings reach, it
+    // grows in the background if a longer one is asked for later
+    auto longestDelay = 0.0;
+
     for (int i = 0; i < num_delays; ++i)
     {
-        delaySamples[i].reset(sampleRate, 0.2f);
-        gainL[i].reset(sampleRate, 0.02f);
-        gainR[i].reset(sampleRate, 0.02f);
+        auto settings = loadTapSettings(i);
+        longestDelay = juce::jmax(longestDelay, getDelaySeconds(settings) + settings.depth / 1000.0);
     }
-    blendSmooth.reset(sampleRate, 0.02f);
-    
-    // Set up delayBuffer and wetBuffer
-    auto delayBufferSize = sampleRate * delay_buffer_length;
-    delayBuffer.setSize(getTotalNumOutputChannels(), static_cast<int>(delayBufferSize));
-    delayBuffer.clear();
 
-    wetBuffer.clear();
+    // A mono input only needs one delay channel, every tap reads it once and
+    // pans it across the outputs
+    auto delayChannels = juce::jlimit(1, getTotalNumOutputChannels(), getTotalNumInputChannels());
+
+    auto delayBufferSize = static_cast<int>(sampleRate * longestDelay) + maxBlockSize;
+    auto storage = isLongDelay() ? DelayLine<SampleType>::Storage::compact : DelayLine<SampleType>::Storage::full;
+
+    // The background thread may be copying from the old line until released
+    state.delayResizer.release();
+    state.delayBuffer.setSize(delayChannels, delayBufferSize, maxBlockSize, storage);
+    state.delayResizer.prepare(state.delayBuffer);
+
+    // Feedback is mixed into the line one channel at a time
+    state.feedbackBuffer.setSize(delayChannels, maxBlockSize);
+    state.feedbackBuffer.clear();
+    state.lineInput.setSize(delayChannels, maxBlockSize);
+    state.crossSmooth.reset(sampleRate, 0.02f);
+    state.crossRamp.setSize(1, maxBlockSize);
 
-    // Set up audio visualizer
-    viz.setNumChannels(getTotalNumOutputChannels());
-    viz.setBufferSize(512);
-    viz.setSamplesPerBlock(256);
+    // Set up wetBuffer
+    state.wetBuffer.setSize(getTotalNumOutputChannels(), maxBlockSize);
+    state.wetBuffer.clear();
+
+    // Program changes fade with the equal-power law
+    auto programFadeLength = juce::jmax(1, static_cast<int>(std::floor(program_fade_seconds * sampleRate)));
+    state.programGains.setSize(2, programFadeLength);
+
+    for (int i = 0; i < programFadeLength; ++i)
+    {
+        auto position = static_cast<float>(i + 1) / static_cast<float>(programFadeLength);
+        state.programGains.setSample(0, i, static_cast<SampleType>(PanLaw::getGain(position)));
+        state.programGains.setSample(1, i, static_cast<SampleType>(PanLaw::getGain(1.0f - position)));
+    }
+
+    state.fadeBuffer.setSize(getTotalNumOutputChannels(), maxBlockSize);
+    state.fadeBuffer.clear();
+    state.programFade = 0;
+
+    state.silentSamples = 0;
+    state.panStepLeft = 0;
+
+    // Cutoffs start where the parameters are
+    for (int i = 0; i < num_delays; ++i)
+    {
+        auto settings = loadTapSettings(i);
+        state.lowPassSmooth[i].reset(sampleRate, 0.02f);
+        state.lowPassSmooth[i].setCurrentAndTargetValue(settings.lowPass);
+        state.highPassSmooth[i].reset(sampleRate, 0.02f);
+        state.highPassSmooth[i].setCurrentAndTargetValue(settings.highPass);
+    }
+
+    state.filterStepLeft = 0;
 }
 
-void SequencedDelay::releaseResources()
+// Frees the delay line and scratch buffers of the precision not in use
+template <typename SampleType>
+void SequencedDelay::releaseState(DspState<SampleType>& state)
 {
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
+    state.delayResizer.release();
+    state.delayBuffer = DelayLine<SampleType>();
+    state.wetBuffer.setSize(0, 0);
+    state.blendRamp.setSize(0, 0);
+    state.programGains.setSize(0, 0);
+    state.fadeBuffer.setSize(0, 0);
+    state.feedbackBuffer.setSize(0, 0);
+    state.lineInput.setSize(0, 0);
+    state.crossRamp.setSize(0, 0);
 }
 
+// Any output layout of up to max_channels, fed by a mono input or by the
+// same layout
 bool SequencedDelay::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    auto output = layouts.getMainOutputChannelSet();
+    auto input = layouts.getMainInputChannelSet();
+
+    if (output.size() < 2 || output.size() > ChannelPanner::max_channels)
         return false;
 
-    if (layouts.getMainInputChannelSet() != juce::AudioChannelSet::stereo()
-        && layouts.getMainInputChannelSet() != juce::AudioChannelSet::mono())
+    if (input != juce::AudioChannelSet::mono() && input.size() != output.size())
         return false;
 
     return true;
@@ -108,156 +290,581 @@ bool SequencedDelay::isBusesLayoutSupported (const BusesLayout& layouts) const
 //==============================================================================
 void SequencedDelay::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    process(buffer, floatState);
+}
+
+void SequencedDelay::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process(buffer, doubleState);
+}
+
+// Shared body of both processBlock overloads
+template <typename SampleType>
+void SequencedDelay::process(juce::AudioBuffer<SampleType>& buffer, DspState<SampleType>& state)
+{
+    ScopedRealtimeCheck realtimeCheck(!isNonRealtime());
+    SEQUENCEDDELAY_PROFILE_SCOPE(profiler, process_block, buffer.getNumSamples());
+    juce::ScopedNoDenormals noDenormals;
+
     auto inputChannels  = getTotalNumInputChannels();
     auto outputChannels = getTotalNumOutputChannels();
+    auto numSamples = buffer.getNumSamples();
 
     if (auto playhead = this->getPlayHead())
     {
         playhead->getCurrentPosition(pos);
     }
 
-    // Use global variable mainBuffer to provide access to buffer in helper methods
-    mainBuffer = &buffer;
-
-    bufferSize = mainBuffer->getNumSamples();
-    delayBufferSize = delayBuffer.getNumSamples();
-
-    // For mono inputs, copy left channel to right channel
+    // For mono inputs, copy the input to every output channel. The dry mix
+    // keeps it on the centre or front speakers only
     for (int channel = inputChannels; channel < outputChannels; ++channel)
     {
-        buffer.clear(channel, 0, buffer.getNumSamples());
-        mainBuffer->copyFrom(channel, 0, mainBuffer->getReadPointer(channel % inputChannels, 0), bufferSize);
+        buffer.clear(channel, 0, numSamples);
+        buffer.copyFrom(channel, 0, buffer.getReadPointer(channel % inputChannels, 0), numSamples);
     }
 
-    viz.pushBuffer(*mainBuffer);
+    peaks.push(buffer, numSamples);
 
-    wetBuffer.setSize(getTotalNumOutputChannels(), bufferSize);
+    // Long delay mode raises the longest delay time and stores the line
+    // compactly. The line is converted like it is grown, in the background
+    // unless rendering offline
+    auto isLong = isLongDelay();
+    auto storage = isLong ? DelayLine<SampleType>::Storage::compact : DelayLine<SampleType>::Storage::full;
 
-    loadDelayBuffer();
+    if (isLong != settingsLongDelay)
+    {
+        settingsLongDelay = isLong;
+        settingsValid = false;
+    }
 
-    for (size_t i = 0; i < num_delays; ++i)
+    state.delayResizer.requestStorage(storage);
+
+    if (isNonRealtime() && storage != state.delayBuffer.getStorage())
     {
-        writeDelay(i);
+        state.delayResizer.growNow(state.delayBuffer, state.delayBuffer.getLength(), storage);
+        settingsValid = false;
     }
 
-    writePosition += bufferSize;
-    writePosition %= delayBufferSize;
+    // A grown or converted delay line lifts the clamp on any delay that did
+    // not fit
+    if (state.delayResizer.swapIfReady(state.delayBuffer))
+        settingsValid = false;
+
+    state.taps->setTimeMode(*timeMode > 0.5f ? TapEngine<SampleType>::TimeMode::crossfade
+                                              : TapEngine<SampleType>::TimeMode::ramp);
 
-    // Dry/wet mixing
-    blendSmooth.setTargetValue(*blend);
-    float wetGain;
+    // A new program waits for the last program change to finish fading.
+    // Parameters are left alone in the block that switches, and while a
+    // program is pending or being written. loadingProgram is set before
+    // pendingProgram, so reading it after the exchange sees any write that
+    // is still going.
+    auto isSwitching = false;
+
+    if (state.programFade == 0)
+        if (auto* program = pendingProgram.exchange(nullptr))
+        {
+            switchProgram(state, *program);
+            isSwitching = true;
+        }
 
-    // https://www.youtube.com/watch?v=HpGJH_gKRCU
-    for (int sample = 0; sample < mainBuffer->getNumSamples(); ++sample)
+    if (!isSwitching && !loadingProgram.load() && pendingProgram.load() == nullptr)
+        updateTaps(state);
+
+    // Feedback repeats the longest delay until the loop has decayed to silence
+    auto tail = getLongestDelay(state) / getSampleRate();
+
+    if (loopGain > 0.0f)
+        tail *= 1.0 + std::ceil(std::log(silence_level) / std::log(loopGain));
+
+    if (tail != tailSeconds.load())
+        tailSeconds = tail;
+
+    state.blendSmooth.setTargetValue(static_cast<SampleType>(*blend));
+    state.crossSmooth.setTargetValue(static_cast<SampleType>(*cross / 100.0f));
+
+    auto isPanModulated = std::any_of(std::begin(tapSettings), std::end(tapSettings),
+        [] (const TapSettings& settings) { return settings.panDepth > 0.0f && settings.gain > 0.0f; });
+
+    auto isFilterMoving = false;
+
+    for (int i = 0; i < num_delays; ++i)
+        isFilterMoving = isFilterMoving || state.lowPassSmooth[i].isSmoothing() || state.highPassSmooth[i].isSmoothing();
+
+    if (!isFilterMoving)
+        state.filterStepLeft = 0;
+
+    // Host blocks larger than prepared are processed in maxBlockSize pieces,
+    // and no piece is longer than the feedback taps can render without
+    // reading it, or than a pan LFO or filter step
+    for (bufferStart = 0; bufferStart < numSamples; bufferStart += bufferSize)
     {
-        wetGain = blendSmooth.getNextValue() / 100.0f;
+        bufferSize = juce::jmin(maxBlockSize, numSamples - bufferStart, state.taps->getMaxFeedbackBlockSize());
+
+        // Steps are counted across pieces, so they land on the same samples
+        // however the host splits its blocks
+        if (isPanModulated)
+        {
+            if (state.panStepLeft == 0)
+            {
+                state.panStepLeft = pan_modulation_block_size;
+                modulatePans(state, state.panStepLeft);
+            }
+
+            bufferSize = juce::jmin(bufferSize, state.panStepLeft);
+        }
+
+        if (isFilterMoving)
+        {
+            if (state.filterStepLeft == 0)
+            {
+                state.filterStepLeft = filter_step_size;
+                stepFilters(state, state.filterStepLeft);
+            }
+
+            bufferSize = juce::jmin(bufferSize, state.filterStepLeft);
+            state.filterStepLeft -= bufferSize;
+        }
+
+        if (isPanModulated)
+            state.panStepLeft -= bufferSize;
+
+        // Both passes over the taps time into one record of the piece
+        SEQUENCEDDELAY_PROFILE_SPLIT(profiler, tap_loop, bufferSize, tapTimer);
+
+        // Feedback taps are rendered first, their output goes into this
+        // block of the line. Once the line they read is silent they are
+        // left to the idle check below, which is then sure to pass.
+        auto hasFeedback = false;
+
+        if (state.silentSamples < getLongestDelay(state))
+        {
+            SEQUENCEDDELAY_PROFILE_PART(tapTimer);
+            hasFeedback = state.taps->processFeedback(state.delayBuffer, state.wetBuffer, state.feedbackBuffer,
+                bufferSize, &workers);
+        }
+
+        loadDelayBuffer(buffer, state, hasFeedback);
+
+        auto numFade = juce::jmin(state.programFade, bufferSize);
+
+        // Once every sample the taps can reach is silent the wet signal is
+        // silent too, so only the ramps need to move on
+        if (state.silentSamples >= getLongestDelay(state) + bufferSize)
+        {
+            state.taps->skip(bufferSize);
+            SEQUENCEDDELAY_PROFILE_ACTIVE_TAPS(profiler, 0);
+        }
+        else
+        {
+            SEQUENCEDDELAY_PROFILE_PART(tapTimer);
+            state.taps->process(state.delayBuffer, state.wetBuffer, bufferSize, &workers);
+
+            if (numFade > 0)
+                fadeProgram(state, numFade);
+
+            SEQUENCEDDELAY_PROFILE_ACTIVE_TAPS(profiler, state.taps->getNumActiveTaps());
+        }
+
+        state.programFade -= numFade;
+
+        state.delayBuffer.advance(bufferSize);
+
+        mixDryWet(buffer, state);
 
         for (int channel = 0; channel < outputChannels; ++channel)
         {
-            auto* dryData = mainBuffer->getWritePointer(channel, sample);
-            auto* wetData = wetBuffer.getReadPointer(channel, sample);
-            *dryData *= 1.0f - wetGain;
-            *dryData += *wetData * wetGain;
+            state.wetBuffer.clear(channel, 0, bufferSize);
         }
     }
-
-    wetBuffer.clear();
 }
 
-// Loads the delayBuffer with new incoming information
-void SequencedDelay::loadDelayBuffer()
+// Crossfades buffer towards wetBuffer by the smoothed blend amount
+// https://www.youtube.com/watch?v=HpGJH_gKRCU
+template <typename SampleType>
+void SequencedDelay::mixDryWet(juce::AudioBuffer<SampleType>& buffer, DspState<SampleType>& state)
 {
+    SEQUENCEDDELAY_PROFILE_SCOPE(profiler, dry_wet_mix, bufferSize);
+
     auto outputChannels = getTotalNumOutputChannels();
-    
+    auto* wetGain = state.blendRamp.getWritePointer(0);
+    auto* dryGain = state.blendRamp.getWritePointer(1);
+
+    // Samples past numRamp use the settled blend
+    auto numRamp = state.blendSmooth.fillRamp(wetGain, bufferSize);
+
+    for (int sample = 0; sample < numRamp; ++sample)
+    {
+        wetGain[sample] /= SampleType(100);
+        dryGain[sample] = SampleType(1) - wetGain[sample];
+    }
+
+    auto settledWetGain = state.blendSmooth.getTargetValue() / SampleType(100);
+
+    // Every channel holds a mono input, so it is only heard where the
+    // panner images the dry signal
+    auto isMonoInput = getTotalNumInputChannels() == 1;
+
     for (int channel = 0; channel < outputChannels; ++channel)
     {
-        auto* channelData = mainBuffer->getReadPointer(channel);
+        auto* dryData = buffer.getWritePointer(channel, bufferStart);
+        auto* wetData = state.wetBuffer.getReadPointer(channel);
 
-        // Check if main buffer copies to delay buffer without going out of bounds
-        if (delayBufferSize > bufferSize + writePosition)
+        if (isMonoInput && panner.getDryGain(channel) != 1.0f)
+            juce::FloatVectorOperations::multiply(dryData, static_cast<SampleType>(panner.getDryGain(channel)), bufferSize);
+
+        if (numRamp > 0)
         {
-            delayBuffer.copyFrom(channel, writePosition, channelData, bufferSize);
+            juce::FloatVectorOperations::multiply(dryData, dryGain, numRamp);
+            juce::FloatVectorOperations::addWithMultiply(dryData, wetData, wetGain, numRamp);
         }
+
+        juce::FloatVectorOperations::multiply(dryData + numRamp, SampleType(1) - settledWetGain, bufferSize - numRamp);
+        juce::FloatVectorOperations::addWithMultiply(dryData + numRamp, wetData + numRamp,
+            settledWetGain, bufferSize - numRamp);
+    }
+}
+
+// Loads the delayBuffer with new incoming information, plus whatever the
+// taps fed back
+template <typename SampleType>
+void SequencedDelay::loadDelayBuffer(const juce::AudioBuffer<SampleType>& buffer, DspState<SampleType>& state,
+    bool hasFeedback)
+{
+    SEQUENCEDDELAY_PROFILE_SCOPE(profiler, load_delay_buffer, bufferSize);
+
+    if (hasFeedback)
+        mixFeedback(buffer, state);
+
+    auto& source = hasFeedback ? state.lineInput : buffer;
+    auto sourceStart = hasFeedback ? 0 : bufferStart;
+    auto isSilent = true;
+
+    for (int channel = 0; channel < state.delayBuffer.getNumChannels(); ++channel)
+    {
+        state.delayBuffer.write(channel, source.getReadPointer(channel, sourceStart), bufferSize);
+        isSilent = isSilent && source.getMagnitude(channel, sourceStart, bufferSize) <= silence_level;
+    }
+
+    // Count how much silence is in the line, stopping well short of overflow
+    state.silentSamples = isSilent ? juce::jmin(state.silentSamples + bufferSize, 1 << 30) : 0;
+}
+
+// Fills lineInput with the input plus the feedback, each line channel taking
+// the cross amount from the next one, so stereo feedback ping-pongs at 100%.
+// A mono line has nothing to cross to.
+template <typename SampleType>
+void SequencedDelay::mixFeedback(const juce::AudioBuffer<SampleType>& buffer, DspState<SampleType>& state)
+{
+    auto numChannels = state.delayBuffer.getNumChannels();
+    auto* crossGain = state.crossRamp.getWritePointer(0);
+
+    // Samples past numRamp use the settled cross amount
+    auto numRamp = state.crossSmooth.fillRamp(crossGain, bufferSize);
+    std::fill(crossGain + numRamp, crossGain + bufferSize, state.crossSmooth.getTargetValue());
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* input = buffer.getReadPointer(channel, bufferStart);
+        auto* own = state.feedbackBuffer.getReadPointer(channel);
+        auto* next = state.feedbackBuffer.getReadPointer((channel + 1) % numChannels);
+        auto* dest = state.lineInput.getWritePointer(channel);
+
+        for (int sample = 0; sample < bufferSize; ++sample)
+            dest[sample] = input[sample] + own[sample] + crossGain[sample] * (next[sample] - own[sample]);
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        state.feedbackBuffer.clear(channel, 0, bufferSize);
+}
+
+// Reads one tap's raw parameter values
+TapSettings SequencedDelay::loadTapSettings(int tap) const
+{
+    return { delay[tap]->load(), sixt[tap]->load(), gain[tap]->load(), pan[tap]->load(), feedback[tap]->load(),
+        lowPass[tap]->load(), highPass[tap]->load(), rate[tap]->load(), depth[tap]->load(), panDepth[tap]->load(),
+        interpolation[tap]->load(), *sync[tap] > 0.5f };
+}
+
+// Delay time of a tap at the current host tempo
+double SequencedDelay::getDelaySeconds(const TapSettings& settings) const
+{
+    auto scale = isLongDelay() ? long_delay_time_scale : 1.0f;
+    auto seconds = settings.sync ? (60.0f / pos.bpm) * (settings.sixt / 4.0f)
+                                 : static_cast<double>(settings.delay * scale / 1000.0f);
+
+    auto maxSeconds = isLongDelay() ? max_long_delay_seconds : max_delay_seconds;
+
+    return juce::jlimit(0.0, static_cast<double>(maxSeconds), seconds);
+}
+
+// Updates the tap engine targets for every delay whose parameters, or whose
+// synced tempo, changed since the last block
+template <typename SampleType>
+void SequencedDelay::updateTaps(DspState<SampleType>& state)
+{
+    auto tempoChanged = pos.bpm != settingsBpm;
+    settingsBpm = pos.bpm;
+
+    TapSettings settings [num_delays];
+
+    for (int i = 0; i < num_delays; ++i)
+        settings[i] = loadTapSettings(i);
+
+    // A new feedback scale touches every tap that feeds back
+    auto scaleChanged = setFeedbackScale(settings);
+
+    for (int i = 0; i < num_delays; ++i)
+    {
+        if (settingsValid && settings[i] == tapSettings[i] && !(settings[i].sync && tempoChanged)
+            && !(scaleChanged && settings[i].feedback > 0.0f))
+            continue;
+
+        tapSettings[i] = settings[i];
+        setTapTarget(state, *state.taps, i, settings[i]);
+    }
+
+    settingsValid = true;
+}
+
+bool SequencedDelay::setFeedbackScale(const TapSettings* settings)
+{
+    auto sum = 0.0f;
+
+    for (int i = 0; i < num_delays; ++i)
+        sum += settings[i].feedback / 100.0f;
+
+    auto scale = sum > max_feedback ? max_feedback / sum : 1.0f;
+    loopGain = sum * scale;
+
+    if (scale == feedbackScale)
+        return false;
+
+    feedbackScale = scale;
+    return true;
+}
+
+// Derives one tap's delay time, channel gains, feedback, filters and LFO for engine
+template <typename SampleType>
+void SequencedDelay::setTapTarget(DspState<SampleType>& state, TapEngine<SampleType>& engine, int tap,
+    const TapSettings& settings)
+{
+    auto sampleRate = getSampleRate();
+
+    // Update delayResult and delay time
+    auto seconds = getDelaySeconds(settings);
+    *delayResult[tap] = settings.sync || isLongDelay() ? static_cast<float>(seconds * 1000.0f) : settings.delay;
+
+    // Kernels other than none keep the part of the delay between samples
+    auto kernel = static_cast<Interpolation>(juce::jlimit(0, 3, juce::roundToInt(settings.interpolation)));
+    auto lookahead = getInterpolationLookahead(kernel);
+    auto exactTarget = sampleRate * seconds;
+    auto delayTarget = juce::jmax(static_cast<int>(exactTarget), lookahead);
+    auto fraction = kernel != Interpolation::none ? juce::jmax(0.0, exactTarget - delayTarget) : 0.0;
+
+    // The LFO and the fraction reach past the whole delay, plus whatever
+    // older samples the kernel reads
+    auto depthSamples = sampleRate * settings.depth / 1000.0;
+    auto reach = depthSamples > 0.0 || fraction > 0.0
+        ? static_cast<int>(std::ceil(depthSamples + fraction)) + getInterpolationReach(kernel) : 0;
+
+    // Delays past the end of the line are clamped until a longer one is
+    // swapped in; offline renders can afford to grow it right here
+    if (delayTarget + reach > state.delayBuffer.getMaxDelay())
+    {
+        auto minimumLength = delayTarget + reach + state.delayBuffer.getGuardLength();
+
+        if (isNonRealtime())
+            state.delayResizer.growNow(state.delayBuffer, minimumLength, state.delayBuffer.getStorage());
         else
-        {
-            int numSamplesToEnd = delayBufferSize - writePosition;
-            int numSamplesAtStart = bufferSize - numSamplesToEnd;
+            state.delayResizer.request(minimumLength);
 
-            // Copy from write to end
-            delayBuffer.copyFrom(channel, writePosition, channelData, numSamplesToEnd);
-            // Copy remaining samples from start onward
-            delayBuffer.copyFrom(channel, 0, channelData + numSamplesToEnd, numSamplesAtStart);
-        }
+        auto maxDelay = state.delayBuffer.getMaxDelay() - getInterpolationReach(kernel);
+
+        if (delayTarget >= maxDelay)
+            fraction = 0.0;
+
+        delayTarget = juce::jmin(delayTarget, maxDelay);
+        depthSamples = juce::jmin(depthSamples, static_cast<double>(maxDelay - delayTarget) - fraction);
     }
+
+    // Taps that feed back read no closer than the engine allows, kernels
+    // that look ahead one sample further
+    auto feedbackGain = settings.feedback / 100.0f * feedbackScale;
+    auto minimumDelay = static_cast<int>(TapEngine<SampleType>::min_feedback_delay) + lookahead;
+
+    if (feedbackGain > 0.0f && delayTarget < minimumDelay)
+    {
+        delayTarget = minimumDelay;
+        fraction = 0.0;
+    }
+
+    // Update gains, silent taps skip the pan law
+    float gains [ChannelPanner::max_channels];
+    SampleType gainTargets [ChannelPanner::max_channels];
+
+    panner.getGains(settings.pan / 100.0f, settings.gain / 100.0f, gains);
+    std::copy(gains, gains + panner.getNumChannels(), gainTargets);
+
+    engine.setInterpolation(tap, kernel);
+    engine.setTarget(tap, delayTarget, gainTargets, static_cast<SampleType>(feedbackGain),
+        static_cast<SampleType>(fraction));
+    engine.setModulation(tap, settings.rate, static_cast<SampleType>(juce::jmax(0.0, depthSamples)));
+
+    // Moving cutoffs are stepped towards their targets by stepFilters
+    state.lowPassSmooth[tap].setTargetValue(settings.lowPass);
+    state.highPassSmooth[tap].setTargetValue(settings.highPass);
+
+    if (!state.lowPassSmooth[tap].isSmoothing() && !state.highPassSmooth[tap].isSmoothing())
+        setTapFilter(engine, tap, settings.lowPass, settings.highPass, 0);
+}
+
+// Stages at the end of their range pass straight through, a low-pass too
+// close to Nyquist to design is as good as off
+template <typename SampleType>
+void SequencedDelay::setTapFilter(TapEngine<SampleType>& engine, int tap, float lowPassHertz, float highPassHertz,
+    int rampLength)
+{
+    auto sampleRate = getSampleRate();
+
+    using Coefficients = juce::dsp::IIR::ArrayCoefficients<SampleType>;
+    typename TapEngine<SampleType>::FilterCoefficients bypass{ { 1, 0, 0, 1, 0, 0 } };
+
+    auto isHighPassOn = highPassHertz > filter_min_hz;
+    auto isLowPassOn = lowPassHertz < filter_max_hz && lowPassHertz < 0.45 * sampleRate;
+
+    auto highPassStage = isHighPassOn ? Coefficients::makeHighPass(sampleRate, static_cast<SampleType>(highPassHertz))
+                                      : bypass;
+    auto lowPassStage = isLowPassOn ? Coefficients::makeLowPass(sampleRate, static_cast<SampleType>(lowPassHertz))
+                                    : bypass;
+
+    engine.setFilter(tap, isHighPassOn || isLowPassOn, highPassStage, lowPassStage, rampLength);
 }
 
-void SequencedDelay::writeDelay(const size_t& delayNum)
+// Designs every moving cutoff where it will be after numSamples, for the
+// heard tap set to interpolate its coefficients towards
+template <typename SampleType>
+void SequencedDelay::stepFilters(DspState<SampleType>& state, int numSamples)
 {
-    // Update delayResult and delaySamples
-    if (!(*sync[delayNum]))
+    for (int i = 0; i < num_delays; ++i)
     {
-        *delayResult[delayNum] = *delay[delayNum] * 1.0f;
-        delaySamples[delayNum].setTargetValue(getSampleRate() * (*delay[delayNum] / 1000.0f));
+        auto& lowPassSmooth = state.lowPassSmooth[i];
+        auto& highPassSmooth = state.highPassSmooth[i];
+
+        if (!lowPassSmooth.isSmoothing() && !highPassSmooth.isSmoothing())
+            continue;
+
+        lowPassSmooth.skip(numSamples);
+        highPassSmooth.skip(numSamples);
+
+        setTapFilter(*state.taps, i, lowPassSmooth.getCurrentValue(), highPassSmooth.getCurrentValue(), numSamples);
     }
-    else
+}
+
+// Makes the idle tap set the heard one, snapped straight to the program, and
+// starts fading out the set that was playing
+template <typename SampleType>
+void SequencedDelay::switchProgram(DspState<SampleType>& state, const PresetBank::Program& program)
+{
+    std::swap(state.taps, state.fadingTaps);
+
+    auto& incoming = *state.taps;
+    incoming.setTimeMode(state.fadingTaps->getTimeMode());
+    setFeedbackScale(program.taps);
+
+    for (int i = 0; i < num_delays; ++i)
     {
-        auto a = (60.0f / pos.bpm) * (*sixt[delayNum] / 4.0f);
-        *delayResult[delayNum] = a * 1000.0f;
-        delaySamples[delayNum].setTargetValue(getSampleRate() * a);
+        tapSettings[i] = program.taps[i];
+        state.lowPassSmooth[i].setCurrentAndTargetValue(tapSettings[i].lowPass);
+        state.highPassSmooth[i].setCurrentAndTargetValue(tapSettings[i].highPass);
+        setTapTarget(state, incoming, i, tapSettings[i]);
     }
 
-    // Update gains
-    auto thisPan = *pan[delayNum] / 100.0f;
-    auto thisGain = *gain[delayNum] / 100.0f;
-    // https://forum.cockos.com/showthread.php?t=49809
-    gainL[delayNum].setTargetValue(sin(0.5f * pi * (1.0f - thisPan)) * thisGain);
-    gainR[delayNum].setTargetValue(sin(0.5f * pi * thisPan) * thisGain);
+    incoming.reset();
+
+    settingsBpm = pos.bpm;
+    settingsValid = true;
 
-    writeDelay(delaySamples[delayNum], gainL[delayNum], gainR[delayNum]);
+    state.programFade = state.programGains.getNumSamples();
 }
 
-// Reads from delayBuffer and copies to wetBuffer
-// @param time - Delay time in samples
-// @param gain - Delay gain
-// @param pan - Delay pan
-void SequencedDelay::writeDelay(juce::SmoothedValue<int>& time, juce::SmoothedValue<float>& gainL, juce::SmoothedValue<float>& gainR)
+// Pan LFOs run at control rate: each step ramps the gains of a swinging tap
+// to where its LFO will be at the end of the step. The LFO swings the pan by
+// up to half the depth either side of the set pan.
+template <typename SampleType>
+void SequencedDelay::modulatePans(DspState<SampleType>& state, int numSamples)
 {
-    auto outputChannels = getTotalNumOutputChannels();
+    float gains [ChannelPanner::max_channels];
+    SampleType gainTargets [ChannelPanner::max_channels];
 
-    for (int sample = 0; sample < mainBuffer->getNumSamples(); ++sample)
+    for (int i = 0; i < num_delays; ++i)
     {
-        int pos = (writePosition + sample - time.getNextValue()
-            + delayBufferSize) % delayBufferSize;
+        auto& settings = tapSettings[i];
 
-        for (int channel = 0; channel < outputChannels; ++channel)
-        {
-            auto* wetData = wetBuffer.getWritePointer(channel, sample);
+        if (settings.panDepth <= 0.0f || settings.gain <= 0.0f)
+            continue;
 
-            auto* bufferData = delayBuffer.getReadPointer(channel,
-                pos);
-            *wetData += *bufferData * (channel == 0 ?
-                gainL.getNextValue() : gainR.getNextValue());
-        }
+        auto swing = settings.panDepth / 200.0f * state.taps->getLfoValue(i, numSamples);
+        auto position = juce::jlimit(0.0f, 1.0f, settings.pan / 100.0f + swing);
+
+        panner.getGains(position, settings.gain / 100.0f, gains);
+        std::copy(gains, gains + panner.getNumChannels(), gainTargets);
+
+        state.taps->setGains(i, gainTargets, numSamples);
     }
 }
 
+// Renders the outgoing tap set and crossfades wetBuffer from it
+template <typename SampleType>
+void SequencedDelay::fadeProgram(DspState<SampleType>& state, int numSamples)
+{
+    state.fadingTaps->process(state.delayBuffer, state.fadeBuffer, numSamples, &workers);
+
+    auto offset = state.programGains.getNumSamples() - state.programFade;
+    auto* fadeIn = state.programGains.getReadPointer(0, offset);
+    auto* fadeOut = state.programGains.getReadPointer(1, offset);
+
+    for (int channel = 0; channel < state.wetBuffer.getNumChannels(); ++channel)
+    {
+        auto* wetData = state.wetBuffer.getWritePointer(channel);
+
+        juce::FloatVectorOperations::multiply(wetData, fadeIn, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(wetData, state.fadeBuffer.getReadPointer(channel), fadeOut, numSamples);
+        state.fadeBuffer.clear(channel, 0, numSamples);
+    }
+}
+
+// Longest delay either tap set can still be heard reading
+template <typename SampleType>
+int SequencedDelay::getLongestDelay(const DspState<SampleType>& state) const
+{
+    auto longest = state.taps->getLongestDelay();
+
+    if (state.programFade > 0)
+        longest = juce::jmax(longest, state.fadingTaps->getLongestDelay());
+
+    return longest;
+}
+
 //==============================================================================
 juce::AudioProcessorEditor* SequencedDelay::createEditor()
 {
     return new SequencedDelayEditor (*this, parameters);
 }
 
-// Saves state information to a juce::MemoryBlock object for storage
+// Saves state information to a juce::MemoryBlock object for storage, in the
+// compact binary format
 void SequencedDelay::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    stateFormat.write(destData);
 }
 
-// Restores parameters from information saved using getStateInformation
+// Restores parameters from information saved using getStateInformation, or
+// from the XML that earlier versions saved
 void SequencedDelay::setStateInformation (const void* data, int sizeInBytes)
 {
+    if (stateFormat.read(data, sizeInBytes))
+        return;
+
     std::unique_ptr<juce::XmlElement> xml(getXmlFromBinary(data, sizeInBytes));
 
     if (xml.get() != nullptr) 
@@ -1,13 +1,19 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "DelayLineResizer.h"
+#include "PanLaw.h"
+#include "PeakFifo.h"
+#include "PresetBank.h"
+#include "Profiler.h"
+#include "StateFormat.h"
+#include "TapEngine.h"
 
 //==============================================================================
 typedef std::shared_ptr<std::atomic<float>> sharedFloat;
 
 //==============================================================================
 const float pi = 2 * acos(0.0);
-static constexpr int num_delays = 16;
 
 //==============================================================================
 class SequencedDelay : public juce::AudioProcessor
@@ -18,6 +24,13 @@ public:
     {
         juce::AudioProcessorValueTreeState::ParameterLayout layout;
 
+        // Filter cutoffs sweep evenly by ear, with 1 kHz halfway
+        juce::NormalisableRange<float> filterRange(filter_min_hz, filter_max_hz);
+        filterRange.setSkewForCentre(1000.0f);
+
+        juce::NormalisableRange<float> rateRange(0.05f, 10.0f);
+        rateRange.setSkewForCentre(1.0f);
+
         for (int i = 1; i <= num_delays; ++i)
         {
             auto numStr = std::to_string(i);
@@ -31,11 +44,37 @@ public:
                 "Delay " + numStr + " Sync", false));
             layout.add(std::make_unique<juce::AudioParameterInt>("sixt" + numStr,
                 "Delay " + numStr + " Sixteenths", 1, 16, 4));
+            layout.add(std::make_unique<juce::AudioParameterFloat>("fdbk" + numStr,
+                "Delay " + numStr + " Feedback", 0.0f, 100.0f, 0.0f));
+            layout.add(std::make_unique<juce::AudioParameterFloat>("lpf" + numStr,
+                "Delay " + numStr + " Low-pass", filterRange, filter_max_hz));
+            layout.add(std::make_unique<juce::AudioParameterFloat>("hpf" + numStr,
+                "Delay " + numStr + " High-pass", filterRange, filter_min_hz));
+            layout.add(std::make_unique<juce::AudioParameterFloat>("rate" + numStr,
+                "Delay " + numStr + " LFO Rate", rateRange, 1.0f));
+            layout.add(std::make_unique<juce::AudioParameterFloat>("depth" + numStr,
+                "Delay " + numStr + " LFO Depth", 0.0f, 50.0f, 0.0f));
+            layout.add(std::make_unique<juce::AudioParameterFloat>("panMod" + numStr,
+                "Delay " + numStr + " Pan LFO", 0.0f, 100.0f, 0.0f));
+            layout.add(std::make_unique<juce::AudioParameterChoice>("interp" + numStr,
+                "Delay " + numStr + " Interpolation", juce::StringArray{ "None", "Linear", "Cubic", "Allpass" }, 0));
         }
 
         layout.add(std::make_unique<juce::AudioParameterFloat>("blend",
             "Dry/Wet", 0.0f, 100.0f, 100.0f));
 
+        // How a tap moves to a new delay time
+        layout.add(std::make_unique<juce::AudioParameterChoice>("timeMode",
+            "Time Change", juce::StringArray{ "Ramp", "Crossfade" }, 0));
+
+        // How much feedback crosses to the next channel, 100% ping-pongs
+        layout.add(std::make_unique<juce::AudioParameterFloat>("cross",
+            "Feedback Cross", 0.0f, 100.0f, 0.0f));
+
+        // Stores the delay line compactly, for longer delays in less memory
+        layout.add(std::make_unique<juce::AudioParameterBool>("longDelay",
+            "Long Delay", false));
+
         return layout;
     }
 
@@ -45,7 +84,7 @@ public:
         AudioProcessor(BusesProperties().withInput("Input", juce::AudioChannelSet::stereo(), true)
             .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
         parameters(*this, nullptr, juce::Identifier("Main"), createParameterLayout()),
-        viz(2)
+        stateFormat(parameters)
     {
         for (int i = 0; i < num_delays; ++i)
         {
@@ -57,9 +96,20 @@ public:
             pan[i] = parameters.getRawParameterValue("pan" + numStr);
             sync[i] = parameters.getRawParameterValue("sync" + numStr);
             sixt[i] = parameters.getRawParameterValue("sixt" + numStr);
+            feedback[i] = parameters.getRawParameterValue("fdbk" + numStr);
+            lowPass[i] = parameters.getRawParameterValue("lpf" + numStr);
+            highPass[i] = parameters.getRawParameterValue("hpf" + numStr);
+            rate[i] = parameters.getRawParameterValue("rate" + numStr);
+            depth[i] = parameters.getRawParameterValue("depth" + numStr);
+            panDepth[i] = parameters.getRawParameterValue("panMod" + numStr);
+            interpolation[i] = parameters.getRawParameterValue("interp" + numStr);
         }
 
         blend = parameters.getRawParameterValue("blend");
+        timeMode = parameters.getRawParameterValue("timeMode");
+        cross = parameters.getRawParameterValue("cross");
+        longDelay = parameters.getRawParameterValue("longDelay");
+        pos.resetToDefault();
     }
 
     inline ~SequencedDelay() override {};
@@ -68,12 +118,18 @@ public:
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
 
+   #if SEQUENCEDDELAY_WORKGROUPS
+    inline void audioWorkgroupContextChanged(const juce::AudioWorkgroup& workgroup) override
+    {
+        workers.setWorkgroup(workgroup);
+    }
+   #endif
+
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-    void loadDelayBuffer();
-    void writeDelay(const size_t& delayNum);
-    void writeDelay(juce::SmoothedValue<int>& time, juce::SmoothedValue<float>& gainL, juce::SmoothedValue<float>& gainR);
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    inline bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==========================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -99,39 +155,190 @@ public:
     void setStateInformation(const void* data, int sizeInBytes) override;
 
     //==========================================================================
-    juce::AudioVisualiserComponent viz;
+    PeakFifo peaks;
+
+   #if SEQUENCEDDELAY_PROFILE
+    Profiler profiler;
+   #endif
     sharedFloat delayResult [num_delays];
 
+    // Channel groups the taps are rendered in, one on the audio thread and
+    // the rest on the workers
+    inline int getNumTapGroups() const { return workers.getNumWorkers() + 1; }
+
+    // Long delay mode stretches the Delay Time range by this, to a minute
+    static constexpr float long_delay_time_scale = 15.0f;
+
 private:
     //==========================================================================
-    juce::AudioBuffer<float>* mainBuffer;
+    int bufferStart{ 0 };
     int bufferSize{ 0 };
+    int maxBlockSize{ 0 };
+
+    // Everything processBlock touches that depends on the sample type. Only
+    // the state matching the host's processing precision is allocated.
+    template <typename SampleType>
+    struct DspState
+    {
+        DelayLine<SampleType> delayBuffer;
+        DelayLineResizer<SampleType> delayResizer;
+
+        juce::AudioBuffer<SampleType> wetBuffer;
+
+        // The heard tap set, and the one a program change is fading out
+        TapEngine<SampleType> tapSets [2];
+        TapEngine<SampleType>* taps = &tapSets[0];
+        TapEngine<SampleType>* fadingTaps = &tapSets[1];
+
+        // Fade in and fade out gains of a program change, and the outgoing
+        // tap set's output while it runs
+        juce::AudioBuffer<SampleType> programGains;
+        juce::AudioBuffer<SampleType> fadeBuffer;
+        int programFade{ 0 };
+
+        RampedValue<SampleType> blendSmooth = { SampleType(0) };
+        juce::AudioBuffer<SampleType> blendRamp;
+
+        // What the taps send back, one channel per delay line channel, and
+        // the line input it is mixed into
+        juce::AudioBuffer<SampleType> feedbackBuffer;
+        juce::AudioBuffer<SampleType> lineInput;
+
+        RampedValue<SampleType> crossSmooth = { SampleType(0) };
+        juce::AudioBuffer<SampleType> crossRamp;
+
+        // Input below silence_level for at least the longest tap delay idles
+        // the tap engine
+        int silentSamples{ 0 };
+
+        // Samples left in the current pan LFO step
+        int panStepLeft{ 0 };
 
-    juce::AudioBuffer<float> delayBuffer;
-    int delayBufferSize{ 0 };
+        // Filter cutoffs of the heard tap set, in Hz, and the samples left
+        // in the current filter step
+        RampedValue<float> lowPassSmooth [num_delays];
+        RampedValue<float> highPassSmooth [num_delays];
+        int filterStepLeft{ 0 };
+    };
 
-    juce::AudioBuffer<float> wetBuffer;
+    DspState<float> floatState;
+    DspState<double> doubleState;
 
-    int writePosition{ 0 };
+    // Pans every tap across the output layout
+    ChannelPanner panner;
 
-    const float delay_buffer_length = 5.0f;
+    // Taps are rendered in groups of at least this many output channels, the
+    // groups in parallel on the worker pool
+    static constexpr int channels_per_group = 4;
+    WorkerPool workers;
+
+    // Host blocks up to this long are processed whole when rendering
+    // offline, as long as no feedback delay is shorter
+    static constexpr int offline_block_size = 8192;
+
+    // Pan LFOs move the tap gains in steps of this many samples
+    static constexpr int pan_modulation_block_size = 64;
+
+    // Moving cutoffs are designed again every step of this many samples, the
+    // coefficients interpolated in between
+    static constexpr int filter_step_size = 64;
+
+    template <typename SampleType> void prepareState(DspState<SampleType>& state, double sampleRate, int numGroups);
+    template <typename SampleType> void releaseState(DspState<SampleType>& state);
+
+    template <typename SampleType> void process(juce::AudioBuffer<SampleType>& buffer, DspState<SampleType>& state);
+    template <typename SampleType> void loadDelayBuffer(const juce::AudioBuffer<SampleType>& buffer, DspState<SampleType>& state,
+        bool hasFeedback);
+    template <typename SampleType> void mixFeedback(const juce::AudioBuffer<SampleType>& buffer, DspState<SampleType>& state);
+    template <typename SampleType> void mixDryWet(juce::AudioBuffer<SampleType>& buffer, DspState<SampleType>& state);
+    template <typename SampleType> void updateTaps(DspState<SampleType>& state);
+    template <typename SampleType> void setTapTarget(DspState<SampleType>& state, TapEngine<SampleType>& engine,
+        int tap, const TapSettings& settings);
+    template <typename SampleType> void switchProgram(DspState<SampleType>& state, const PresetBank::Program& program);
+    template <typename SampleType> void fadeProgram(DspState<SampleType>& state, int numSamples);
+    template <typename SampleType> void modulatePans(DspState<SampleType>& state, int numSamples);
+    template <typename SampleType> void stepFilters(DspState<SampleType>& state, int numSamples);
+    template <typename SampleType> void setTapFilter(TapEngine<SampleType>& engine, int tap, float lowPassHertz,
+        float highPassHertz, int rampLength);
+    template <typename SampleType> int getLongestDelay(const DspState<SampleType>& state) const;
+
+    const float silence_level = juce::Decibels::decibelsToGain(-120.0f);
+    std::atomic<double> tailSeconds{ 0.0 };
+
+    // The delay line grows up to this, enough for 16 synced sixteenths at 8 BPM
+    const float max_delay_seconds = 30.0f;
+
+    // A compact line in long delay mode grows up to this instead
+    const float max_long_delay_seconds = 60.0f;
 
     //==========================================================================
     juce::AudioProcessorValueTreeState parameters;
+    StateFormat stateFormat;
 
     std::atomic<float>* sync [num_delays] = { nullptr };
 
     std::atomic<float>* delay [num_delays] = { nullptr };
     std::atomic<float>* sixt [num_delays] = { nullptr };
-    juce::SmoothedValue<int> delaySamples [num_delays] = { 0 };
 
     std::atomic<float>* gain [num_delays] = { nullptr };
     std::atomic<float>* pan [num_delays] = { nullptr };
-    juce::SmoothedValue<float> gainL[num_delays] = { 0.0f };
-    juce::SmoothedValue<float> gainR[num_delays] = { 0.0f };
+
+    std::atomic<float>* feedback [num_delays] = { nullptr };
+
+    // A filter at the end of this range is bypassed. Static, as the
+    // parameter layout is built before the members
+    static constexpr float filter_min_hz = 20.0f;
+    static constexpr float filter_max_hz = 20000.0f;
+
+    std::atomic<float>* lowPass [num_delays] = { nullptr };
+    std::atomic<float>* highPass [num_delays] = { nullptr };
+
+    // LFO rate in Hz, delay swing in ms and pan swing in percent
+    std::atomic<float>* rate [num_delays] = { nullptr };
+    std::atomic<float>* depth [num_delays] = { nullptr };
+    std::atomic<float>* panDepth [num_delays] = { nullptr };
+
+    // Index of the Interpolation kernel a tap reads with
+    std::atomic<float>* interpolation [num_delays] = { nullptr };
     
+    TapSettings loadTapSettings(int tap) const;
+    double getDelaySeconds(const TapSettings& settings) const;
+
+    // @return - True if the scale changed
+    bool setFeedbackScale(const TapSettings* settings);
+
+    // Parameter values the tap engine targets were last derived from, so
+    // updateTaps only recomputes taps whose inputs changed
+    TapSettings tapSettings [num_delays];
+    double settingsBpm{ 0.0 };
+    bool settingsLongDelay{ false };
+    bool settingsValid{ false };
+
+    // Every tap's feedback is scaled so their sum, the most the loop can
+    // gain per pass, stays below max_feedback
+    const float max_feedback = 0.98f;
+    float feedbackScale{ 1.0f };
+    float loopGain{ 0.0f };
+
     std::atomic<float>* blend = nullptr;
-    juce::SmoothedValue<float> blendSmooth = { 0.0f };
+    std::atomic<float>* timeMode = nullptr;
+    std::atomic<float>* cross = nullptr;
+
+    // Compact delay line storage, and the longer delays it allows
+    std::atomic<float>* longDelay = nullptr;
+    inline bool isLongDelay() const { return *longDelay > 0.5f; }
+
+    //==========================================================================
+    // setCurrentProgram publishes the program here for the audio thread to
+    // pick up whole, then writes it to the parameters with loadingProgram
+    // set so the taps never see it half written
+    PresetBank programs;
+    std::atomic<const PresetBank::Program*> pendingProgram{ nullptr };
+    std::atomic<bool> loadingProgram{ false };
+    std::atomic<int> currentProgram{ 0 };
+
+    // Old and new tap sets crossfade over this long
+    const float program_fade_seconds = 0.03f;
     
     //==========================================================================
     juce::AudioPlayHead::CurrentPositionInfo pos;
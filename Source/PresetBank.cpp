@@ -0,0 +1,57 @@
+#include "PresetBank.h"
+
+//==============================================================================
+PresetBank::PresetBank()
+{
+    programs[0].name = "Init";
+
+    // A bar of quarter notes dying away
+    programs[1].name = "Quarter Echoes";
+    for (int i = 0; i < juce::jmin(4, num_delays); ++i)
+        programs[1].taps[i] = synced(4 * (i + 1), 70.0f * std::pow(0.7f, static_cast<float>(i)), 50.0f);
+
+    // Eighths bouncing hard left and right
+    programs[2].name = "Ping-Pong Eighths";
+    for (int i = 0; i < juce::jmin(8, num_delays); ++i)
+        programs[2].taps[i] = synced(2 * (i + 1), 80.0f * std::pow(0.8f, static_cast<float>(i)), i % 2 == 0 ? 0.0f : 100.0f);
+
+    programs[3].name = "Dotted Eighths";
+    for (int i = 0; i < juce::jmin(5, num_delays); ++i)
+        programs[3].taps[i] = synced(3 * (i + 1), 70.0f * std::pow(0.75f, static_cast<float>(i)), i % 2 == 0 ? 25.0f : 75.0f);
+
+    // Short unsynced doubling
+    programs[4].name = "Slapback";
+    programs[4].taps[0] = timed(90.0f, 60.0f, 50.0f);
+    if (num_delays > 1)
+        programs[4].taps[1] = timed(180.0f, 25.0f, 50.0f);
+
+    // Every sixteenth of a bar, fading out as it sweeps across
+    programs[5].name = "Sixteenth Cascade";
+    auto numCascade = juce::jmin(16, num_delays);
+    for (int i = 0; i < numCascade; ++i)
+    {
+        auto position = numCascade > 1 ? static_cast<float>(i) / static_cast<float>(numCascade - 1) : 0.5f;
+        programs[5].taps[i] = synced(i + 1, 60.0f * (1.0f - static_cast<float>(i) / static_cast<float>(numCascade)),
+            100.0f * position);
+    }
+}
+
+//==============================================================================
+TapSettings PresetBank::synced(int sixteenths, float gain, float pan)
+{
+    TapSettings settings;
+    settings.sixt = static_cast<float>(sixteenths);
+    settings.gain = std::round(gain);
+    settings.pan = std::round(pan);
+    settings.sync = true;
+    return settings;
+}
+
+TapSettings PresetBank::timed(float milliseconds, float gain, float pan)
+{
+    TapSettings settings;
+    settings.delay = milliseconds;
+    settings.gain = std::round(gain);
+    settings.pan = std::round(pan);
+    return settings;
+}
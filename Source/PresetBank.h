@@ -0,0 +1,51 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "TapEngine.h"
+
+//==============================================================================
+// Raw parameter values of one tap, defaulting to a silent tap
+struct TapSettings
+{
+    float delay = 250.0f, sixt = 4.0f, gain = 0.0f, pan = 50.0f, feedback = 0.0f;
+    float lowPass = 20000.0f, highPass = 20.0f, rate = 1.0f, depth = 0.0f, panDepth = 0.0f;
+    float interpolation = 0.0f;
+    bool sync = false;
+
+    inline bool operator== (const TapSettings& other) const
+    {
+        return delay == other.delay && sixt == other.sixt && gain == other.gain
+            && pan == other.pan && feedback == other.feedback && lowPass == other.lowPass
+            && highPass == other.highPass && rate == other.rate && depth == other.depth
+            && panDepth == other.panDepth && interpolation == other.interpolation && sync == other.sync;
+    }
+};
+
+//==============================================================================
+// Built-in programs. Every tap pattern is generated once, for however many
+// taps the build has, and never changes afterwards, so a program change only
+// has to hand the audio thread a pointer. Taps a pattern does not use stay at
+// their silent defaults.
+class PresetBank
+{
+public:
+    //==========================================================================
+    struct Program
+    {
+        juce::String name;
+        TapSettings taps [num_delays];
+    };
+
+    PresetBank();
+
+    inline int size() const { return num_programs; }
+    inline const Program& operator[] (int index) const { return programs[index]; }
+
+private:
+    //==========================================================================
+    static TapSettings synced(int sixteenths, float gain, float pan);
+    static TapSettings timed(float milliseconds, float gain, float pan);
+
+    static constexpr int num_programs = 6;
+    Program programs [num_programs];
+};
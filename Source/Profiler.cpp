@@ -0,0 +1,134 @@
+#include "Profiler.h"
+
+#if SEQUENCEDDELAY_PROFILE
+
+//==============================================================================
+const char* Profiler::getSectionName(int section)
+{
+    switch (section)
+    {
+        case process_block:     return "processBlock";
+        case load_delay_buffer: return "loadDelayBuffer";
+        case tap_loop:          return "taps";
+        case dry_wet_mix:       return "mixDryWet";
+        default:                return "unknown";
+    }
+}
+
+//==============================================================================
+void Profiler::record(int section, juce::int64 ticks, int numSamples)
+{
+    auto seconds = juce::Time::highResolutionTicksToSeconds(ticks);
+    auto nanoseconds = static_cast<juce::uint64>(juce::jmax(seconds, 0.0) * 1.0e9);
+
+    int bucket = 0;
+    while (bucket < num_buckets - 1 && (nanoseconds >> (bucket + 1)) != 0)
+        ++bucket;
+
+    histogram[section][bucket].fetch_add(1, std::memory_order_relaxed);
+
+    // Records are dropped while the ring is full
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 > 0)
+    {
+        records[start1] = { section, numSamples, activeTaps, sampleRate, static_cast<float>(seconds * 1.0e6) };
+        fifo.finishedWrite(1);
+    }
+}
+
+//==============================================================================
+int Profiler::popRecords(ProfileRecord* dest, int maxRecords)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(maxRecords, start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i)
+        dest[i] = records[start1 + i];
+
+    for (int i = 0; i < size2; ++i)
+        dest[size1 + i] = records[start2 + i];
+
+    fifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
+
+juce::uint32 Profiler::getBucketCount(int section, int bucket) const
+{
+    return histogram[section][bucket].load(std::memory_order_relaxed);
+}
+
+// Interpolates inside the bucket that holds the percentile
+double Profiler::getPercentile(int section, double fraction) const
+{
+    juce::uint64 total = 0;
+
+    for (int b = 0; b < num_buckets; ++b)
+        total += getBucketCount(section, b);
+
+    if (total == 0)
+        return 0.0;
+
+    auto target = fraction * static_cast<double>(total);
+    double below = 0.0;
+
+    for (int b = 0; b < num_buckets; ++b)
+    {
+        auto count = static_cast<double>(getBucketCount(section, b));
+
+        if (below + count >= target && count > 0.0)
+        {
+            auto low = std::ldexp(1.0, b);
+            return (low + low * (target - below) / count) * 1.0e-3;
+        }
+
+        below += count;
+    }
+
+    return std::ldexp(1.0, num_buckets) * 1.0e-3;
+}
+
+juce::var Profiler::toJson(const ProfileRecord* recent, int numRecent) const
+{
+    auto* sections = new juce::DynamicObject();
+
+    for (int s = 0; s < num_sections; ++s)
+    {
+        juce::Array<juce::var> buckets;
+
+        for (int b = 0; b < num_buckets; ++b)
+            buckets.add(static_cast<juce::int64>(getBucketCount(s, b)));
+
+        auto* section = new juce::DynamicObject();
+        section->setProperty("bucketsLog2Nanoseconds", buckets);
+        section->setProperty("p50Microseconds", getPercentile(s, 0.5));
+        section->setProperty("p99Microseconds", getPercentile(s, 0.99));
+        sections->setProperty(getSectionName(s), juce::var(section));
+    }
+
+    juce::Array<juce::var> records;
+
+    for (int i = 0; i < numRecent; ++i)
+    {
+        auto& r = recent[i];
+
+        auto* record = new juce::DynamicObject();
+        record->setProperty("section", getSectionName(r.section));
+        record->setProperty("samples", r.numSamples);
+        record->setProperty("activeTaps", r.activeTaps);
+        record->setProperty("sampleRate", r.sampleRate);
+        record->setProperty("microseconds", r.microseconds);
+        records.add(juce::var(record));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("profile", "SequencedDelay");
+    root->setProperty("version", 1);
+    root->setProperty("sections", juce::var(sections));
+    root->setProperty("recent", records);
+
+    return juce::var(root);
+}
+
+#endif
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Optional hot-path instrumentation. Define SEQUENCEDDELAY_PROFILE=1 to time
+// processBlock and its stages; every timing goes into a lock-free ring of
+// recent records and a fixed histogram per section. Otherwise the macros
+// below expand to nothing and no Profiler exists.
+#ifndef SEQUENCEDDELAY_PROFILE
+ #define SEQUENCEDDELAY_PROFILE 0
+#endif
+
+#if SEQUENCEDDELAY_PROFILE
+
+//==============================================================================
+// One timed section of one callback
+struct ProfileRecord
+{
+    int section;
+    int numSamples;
+    int activeTaps;
+    float sampleRate;
+    float microseconds;
+};
+
+//==============================================================================
+class Profiler
+{
+public:
+    //==========================================================================
+    enum Section
+    {
+        process_block,
+        load_delay_buffer,
+        tap_loop,
+        dry_wet_mix,
+        num_sections
+    };
+
+    // Bucket b counts timings from 2^b up to 2^(b+1) nanoseconds
+    static constexpr int num_buckets = 32;
+
+    static const char* getSectionName(int section);
+
+    //==========================================================================
+    // Audio thread
+    inline void setSampleRate(double newSampleRate) { sampleRate = static_cast<float>(newSampleRate); }
+    inline void setActiveTaps(int numTaps) { activeTaps = numTaps; }
+
+    void record(int section, juce::int64 ticks, int numSamples);
+
+    // Times the enclosing scope into one section
+    class ScopedTimer
+    {
+    public:
+        inline ScopedTimer(Profiler& p, int s, int n)
+            : profiler(p), section(s), numSamples(n), start(juce::Time::getHighResolutionTicks()) {}
+
+        inline ~ScopedTimer()
+        {
+            profiler.record(section, juce::Time::getHighResolutionTicks() - start, numSamples);
+        }
+
+    private:
+        Profiler& profiler;
+        int section, numSamples;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedTimer)
+    };
+
+    // Adds up the scopes of its Parts into one section, recorded once when
+    // it goes out of scope, if any Part ran
+    class SplitTimer
+    {
+    public:
+        inline SplitTimer(Profiler& p, int s, int n) : profiler(p), section(s), numSamples(n) {}
+
+        inline ~SplitTimer()
+        {
+            if (hasRun)
+                profiler.record(section, ticks, numSamples);
+        }
+
+        // Times the enclosing scope into a SplitTimer
+        class Part
+        {
+        public:
+            inline explicit Part(SplitTimer& t) : timer(t), start(juce::Time::getHighResolutionTicks()) {}
+
+            inline ~Part()
+            {
+                timer.ticks += juce::Time::getHighResolutionTicks() - start;
+                timer.hasRun = true;
+            }
+
+        private:
+            SplitTimer& timer;
+            juce::int64 start;
+
+            JUCE_DECLARE_NON_COPYABLE (Part)
+        };
+
+    private:
+        Profiler& profiler;
+        int section, numSamples;
+        juce::int64 ticks{ 0 };
+        bool hasRun{ false };
+
+        JUCE_DECLARE_NON_COPYABLE (SplitTimer)
+    };
+
+    //==========================================================================
+    // Message thread
+    // @return - Number of records written to dest
+    int popRecords(ProfileRecord* dest, int maxRecords);
+
+    juce::uint32 getBucketCount(int section, int bucket) const;
+
+    // Estimated percentile of a section's timings, in microseconds
+    double getPercentile(int section, double fraction) const;
+
+    // Histograms plus the given recent records
+    juce::var toJson(const ProfileRecord* recent, int numRecent) const;
+
+private:
+    //==========================================================================
+    static constexpr int ring_size = 4096;
+
+    juce::AbstractFifo fifo{ ring_size };
+    ProfileRecord records [ring_size];
+
+    std::atomic<juce::uint32> histogram [num_sections][num_buckets] = {};
+
+    float sampleRate{ 0.0f };
+    int activeTaps{ 0 };
+};
+
+ #define SEQUENCEDDELAY_PROFILE_SCOPE(profiler, section, numSamples) \
+    Profiler::ScopedTimer JUCE_JOIN_MACRO(profileScope, __LINE__) (profiler, Profiler::section, numSamples)
+ #define SEQUENCEDDELAY_PROFILE_SPLIT(profiler, section, numSamples, timer) \
+    Profiler::SplitTimer timer (profiler, Profiler::section, numSamples)
+ #define SEQUENCEDDELAY_PROFILE_PART(timer) \
+    Profiler::SplitTimer::Part JUCE_JOIN_MACRO(profilePart, __LINE__) (timer)
+ #define SEQUENCEDDELAY_PROFILE_ACTIVE_TAPS(profiler, numTaps) (profiler).setActiveTaps(numTaps)
+
+#else
+ #define SEQUENCEDDELAY_PROFILE_SCOPE(profiler, section, numSamples)
+ #define SEQUENCEDDELAY_PROFILE_SPLIT(profiler, section, numSamples, timer)
+ #define SEQUENCEDDELAY_PROFILE_PART(timer)
+ #define SEQUENCEDDELAY_PROFILE_ACTIVE_TAPS(profiler, numTaps)
+#endif
@@ -0,0 +1,175 @@
+#include "RealtimeCheck.h"
+
+#if SEQUENCEDDELAY_RT_CHECK
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_LINUX
+ #include <cerrno>
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+//==============================================================================
+// Set while the current thread is inside processBlock. The malloc hooks
+// below read it, so on Linux it must be reachable without the lazy TLS
+// setup that itself calls malloc.
+#if JUCE_LINUX
+static thread_local bool isChecking __attribute__ ((tls_model ("initial-exec"))) = false;
+#else
+static thread_local bool isChecking = false;
+#endif
+
+ScopedRealtimeCheck::ScopedRealtimeCheck(bool isRealtime) : wasChecking(isChecking)
+{
+    isChecking = isRealtime;
+}
+
+ScopedRealtimeCheck::~ScopedRealtimeCheck()
+{
+    isChecking = wasChecking;
+}
+
+// Prints without allocating, then aborts so the violation cannot be missed
+void ScopedRealtimeCheck::violation(const char* what)
+{
+    isChecking = false;
+
+    std::fputs("SequencedDelay real-time violation in processBlock: ", stderr);
+    std::fputs(what, stderr);
+    std::fputs("\n", stderr);
+    std::fflush(stderr);
+
+    jassertfalse;
+    std::abort();
+}
+
+//==============================================================================
+static void* checkedAllocate(std::size_t size)
+{
+    if (isChecking)
+        ScopedRealtimeCheck::violation("operator new");
+
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+static void checkedFree(void* ptr) noexcept
+{
+    if (ptr != nullptr && isChecking)
+        ScopedRealtimeCheck::violation("operator delete");
+
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size) { return checkedAllocate(size); }
+void* operator new[](std::size_t size) { return checkedAllocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return checkedAllocate(size); }
+    catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return checkedAllocate(size); }
+    catch (...) { return nullptr; }
+}
+
+void operator delete(void* ptr) noexcept { checkedFree(ptr); }
+void operator delete[](void* ptr) noexcept { checkedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { checkedFree(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { checkedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { checkedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { checkedFree(ptr); }
+
+//==============================================================================
+// Interposes the pthread mutex used by juce::CriticalSection and friends.
+// This catches locks taken from the plugin's own code and from any
+// executable it is linked into, such as the benchmark.
+#if JUCE_LINUX
+// Interposes the C allocator, which libraries and C code call directly.
+// glibc's __libc_ entry points reach the real allocator without dlsym, which
+// allocates itself.
+extern "C"
+{
+    void* __libc_malloc(std::size_t);
+    void* __libc_calloc(std::size_t, std::size_t);
+    void* __libc_realloc(void*, std::size_t);
+    void* __libc_memalign(std::size_t, std::size_t);
+    void __libc_free(void*);
+
+    void* malloc(std::size_t size) noexcept
+    {
+        if (isChecking)
+            ScopedRealtimeCheck::violation("malloc");
+
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size) noexcept
+    {
+        if (isChecking)
+            ScopedRealtimeCheck::violation("calloc");
+
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, std::size_t size) noexcept
+    {
+        if (isChecking)
+            ScopedRealtimeCheck::violation("realloc");
+
+        return __libc_realloc(ptr, size);
+    }
+
+    int posix_memalign(void** result, std::size_t alignment, std::size_t size) noexcept
+    {
+        if (isChecking)
+            ScopedRealtimeCheck::violation("posix_memalign");
+
+        if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        auto* ptr = __libc_memalign(alignment, size);
+
+        if (ptr == nullptr)
+            return ENOMEM;
+
+        *result = ptr;
+        return 0;
+    }
+
+    void free(void* ptr) noexcept
+    {
+        if (ptr != nullptr && isChecking)
+            ScopedRealtimeCheck::violation("free");
+
+        __libc_free(ptr);
+    }
+}
+
+//==============================================================================
+using MutexLockFunction = int (*)(pthread_mutex_t*);
+
+static MutexLockFunction realMutexLock
+    = reinterpret_cast<MutexLockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    if (isChecking)
+        ScopedRealtimeCheck::violation("pthread_mutex_lock");
+
+    if (realMutexLock == nullptr)
+        realMutexLock = reinterpret_cast<MutexLockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+
+    return realMutexLock(mutex);
+}
+#endif
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Debug/test mode that aborts when the audio thread allocates, frees or (on
+// Linux) locks a mutex while a ScopedRealtimeCheck is alive. Define
+// SEQUENCEDDELAY_RT_CHECK=1 to replace the global new/delete operators, and
+// on Linux malloc and friends; otherwise the check compiles away to nothing. Offline renders pass
+// isRealtime = false, which suspends the check for the scope.
+#ifndef SEQUENCEDDELAY_RT_CHECK
+ #define SEQUENCEDDELAY_RT_CHECK 0
+#endif
+
+//==============================================================================
+class ScopedRealtimeCheck
+{
+public:
+   #if SEQUENCEDDELAY_RT_CHECK
+    explicit ScopedRealtimeCheck(bool isRealtime = true);
+    ~ScopedRealtimeCheck();
+
+    // Called when something not real-time safe happens inside a check
+    static void violation(const char* what);
+
+private:
+    bool wasChecking;
+   #else
+    explicit ScopedRealtimeCheck(bool = true) {}
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeCheck)
+};
@@ -0,0 +1,54 @@
+#include "SineTable.h"
+
+//==============================================================================
+// The extra entry lets a read just below table_size interpolate to the start
+struct SineTableValues
+{
+    SineTableValues()
+    {
+        for (int i = 0; i < SineTable::table_size; ++i)
+            values[i] = static_cast<float>(std::sin(juce::MathConstants<double>::twoPi
+                * static_cast<double>(i) / SineTable::table_size));
+
+        values[SineTable::table_size] = values[0];
+    }
+
+    float values [SineTable::table_size + 1];
+};
+
+static const SineTableValues sineTable;
+
+//==============================================================================
+// The top table_bits of a phase pick the entry, the rest interpolate
+static constexpr int fraction_bits = 32 - SineTable::table_bits;
+static constexpr float fraction_scale = 1.0f / static_cast<float>(1u << fraction_bits);
+
+static inline float lookUp(SineTable::Phase phase)
+{
+    auto index = static_cast<int>(phase >> fraction_bits);
+    auto fraction = static_cast<float>(phase & ((1u << fraction_bits) - 1)) * fraction_scale;
+
+    auto* values = sineTable.values;
+    return values[index] + fraction * (values[index + 1] - values[index]);
+}
+
+//==============================================================================
+SineTable::Phase SineTable::getIncrement(double rateHertz, double sampleRate)
+{
+    auto cycles = juce::jlimit(0.0, 0.5, rateHertz / sampleRate);
+    return static_cast<Phase>(std::llround(cycles * 4294967296.0));
+}
+
+float SineTable::get(Phase phase)
+{
+    return lookUp(phase);
+}
+
+void SineTable::fill(Phase phase, Phase increment, float* dest, int numSamples)
+{
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        dest[sample] = lookUp(phase);
+        phase += increment;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// One cycle of sine sampled once into a table shared by every instance and
+// linearly interpolated, for the tap LFOs. Phases are fixed point, a whole
+// cycle being 2^32, so they wrap by themselves and moving on by n samples
+// lands on the same phase however the n samples are split.
+class SineTable
+{
+public:
+    //==========================================================================
+    using Phase = juce::uint32;
+
+    static constexpr int table_bits = 11;
+    static constexpr int table_size = 1 << table_bits;
+
+    // @return - The phase increment per sample of a sine at rateHertz
+    static Phase getIncrement(double rateHertz, double sampleRate);
+
+    // @return - The phase numSamples on from phase
+    static inline Phase advance(Phase phase, Phase increment, juce::int64 numSamples)
+    {
+        return phase + increment * static_cast<Phase>(numSamples);
+    }
+
+    // @return - -1 to 1
+    static float get(Phase phase);
+
+    // Writes numSamples values, starting at phase and moving on by increment
+    // every sample
+    static void fill(Phase phase, Phase increment, float* dest, int numSamples);
+};
@@ -0,0 +1,129 @@
+#include "StateFormat.h"
+
+//==============================================================================
+StateFormat::StateFormat(juce::AudioProcessorValueTreeState& parameters)
+{
+    for (auto* parameter : parameters.processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            entries.add({ getHash(ranged->paramID), ranged, parameters.getRawParameterValue(ranged->paramID) });
+}
+
+// FNV-1a over the UTF-8 ID, fixed here so states do not depend on how a JUCE
+// version hashes strings
+juce::uint32 StateFormat::getHash(const juce::String& parameterID)
+{
+    juce::uint32 hash = 2166136261u;
+
+    for (auto* c = parameterID.toRawUTF8(); *c != 0; ++c)
+    {
+        hash ^= static_cast<juce::uint8>(*c);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+//==============================================================================
+void StateFormat::write(juce::MemoryBlock& dest) const
+{
+    dest.setSize(static_cast<size_t>(header_size + entry_size * entries.size()));
+    auto* bytes = static_cast<char*>(dest.getData());
+
+    auto writeWord = [&bytes] (juce::uint32 word)
+    {
+        auto littleEndian = juce::ByteOrder::swapIfBigEndian(word);
+        std::memcpy(bytes, &littleEndian, 4);
+        bytes += 4;
+    };
+
+    writeWord(magic);
+    writeWord(version);
+    writeWord(static_cast<juce::uint32>(entries.size()));
+
+    for (auto& entry : entries)
+    {
+        juce::uint32 valueBits;
+        auto value = entry.value->load();
+        std::memcpy(&valueBits, &value, 4);
+
+        writeWord(entry.hash);
+        writeWord(valueBits);
+    }
+}
+
+bool StateFormat::read(const void* data, int sizeInBytes) const
+{
+    if (data == nullptr || sizeInBytes < header_size)
+        return false;
+
+    auto* bytes = static_cast<const char*>(data);
+
+    if (juce::ByteOrder::littleEndianInt(bytes) != magic)
+        return false;
+
+    // Later versions may add fields this build cannot skip safely
+    if (juce::ByteOrder::littleEndianInt(bytes + 4) > version)
+        return false;
+
+    auto numEntries = static_cast<int>(juce::ByteOrder::littleEndianInt(bytes + 8));
+
+    if (numEntries < 0 || numEntries > (sizeInBytes - header_size) / entry_size)
+        return false;
+
+    bytes += header_size;
+
+    // A value that is not finite would reach the DSP as it is, so the whole
+    // state is rejected before anything changes
+    for (int i = 0; i < numEntries; ++i)
+        if (!std::isfinite(getValue(bytes + i * entry_size)))
+            return false;
+
+    std::vector<bool> isListed(static_cast<size_t>(entries.size()), false);
+
+    for (int i = 0; i < numEntries; ++i, bytes += entry_size)
+    {
+        auto hash = juce::ByteOrder::littleEndianInt(bytes);
+        auto value = getValue(bytes);
+
+        // Same build, same order; otherwise look the parameter up
+        auto index = i < entries.size() && entries.getReference(i).hash == hash ? i : -1;
+
+        for (int e = 0; index < 0 && e < entries.size(); ++e)
+            if (entries.getReference(e).hash == hash)
+                index = e;
+
+        if (index >= 0)
+        {
+            setValue(entries.getReference(index), value);
+            isListed[static_cast<size_t>(index)] = true;
+        }
+    }
+
+    // As with replaceState, parameters the state leaves out go back to their
+    // defaults rather than keeping whatever was set before
+    for (int e = 0; e < entries.size(); ++e)
+    {
+        auto* parameter = entries.getReference(e).parameter;
+
+        if (!isListed[static_cast<size_t>(e)] && parameter->getValue() != parameter->getDefaultValue())
+            parameter->setValueNotifyingHost(parameter->getDefaultValue());
+    }
+
+    return true;
+}
+
+float StateFormat::getValue(const char* entry)
+{
+    auto valueBits = juce::ByteOrder::littleEndianInt(entry + 4);
+
+    float value;
+    std::memcpy(&value, &valueBits, 4);
+    return value;
+}
+
+// Goes through the host notification path, as replaceState does
+void StateFormat::setValue(const Entry& entry, float value) const
+{
+    if (value != entry.value->load())
+        entry.parameter->setValueNotifyingHost(entry.parameter->convertTo0to1(value));
+}
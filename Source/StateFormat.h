@@ -0,0 +1,55 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Compact binary plugin state. Every parameter is stored as the hash of its
+// ID and its value, so saving is one pass over the parameters and loading is
+// one pass over the entries with no text to parse. Entries are matched to
+// parameters by position first and by hash otherwise, so states saved by a
+// build with another tap count still load. Parameters a state leaves out go
+// back to their defaults, as they do when an XML state loads.
+//
+// Version 1, little endian:
+//   uint32  magic, "SQDL"
+//   uint32  version
+//   uint32  number of entries
+//   entries of { uint32 FNV-1a hash of the parameter ID, float32 value }
+class StateFormat
+{
+public:
+    //==========================================================================
+    static constexpr juce::uint32 magic = 0x4c445153;
+    static constexpr juce::uint32 version = 1;
+
+    // Call once every parameter has been added to parameters
+    explicit StateFormat(juce::AudioProcessorValueTreeState& parameters);
+
+    void write(juce::MemoryBlock& dest) const;
+
+    // @return - False if data is not a binary state this build can read,
+    //           such as the XML written by earlier versions, or holds a
+    //           value that is not finite
+    bool read(const void* data, int sizeInBytes) const;
+
+    static juce::uint32 getHash(const juce::String& parameterID);
+
+private:
+    //==========================================================================
+    struct Entry
+    {
+        juce::uint32 hash;
+        juce::RangedAudioParameter* parameter;
+        std::atomic<float>* value;
+    };
+
+    void setValue(const Entry& entry, float value) const;
+
+    // @return - The value of the entry starting at entry
+    static float getValue(const char* entry);
+
+    static constexpr int header_size = 12;
+    static constexpr int entry_size = 8;
+
+    juce::Array<Entry> entries;
+};
@@ -0,0 +1,992 @@
+#include "TapEngine.h"
+
+//==============================================================================
+template <typename SampleType>
+void TapEngine<SampleType>::prepare(double sampleRate, int maxBlockSize, int numChannels, int numGroups)
+{
+    timeRampLength = static_cast<int>(std::floor(0.2f * sampleRate));
+    gainRampLength = static_cast<int>(std::floor(0.02f * sampleRate));
+    lfoSampleRate = sampleRate;
+
+    this->numChannels = juce::jlimit(0, static_cast<int>(max_channels), numChannels);
+    this->numGroups = juce::jlimit(1, juce::jmin(static_cast<int>(max_groups), juce::jmax(this->numChannels, 1)), numGroups);
+
+    this->maxBlockSize = juce::jmax(maxBlockSize, 1);
+
+    fadeLength = juce::jmax(1, static_cast<int>(std::floor(0.05f * sampleRate)));
+    fadeIn.allocate(static_cast<size_t>(fadeLength), true);
+    fadeOut.allocate(static_cast<size_t>(fadeLength), true);
+
+    for (int i = 0; i < fadeLength; ++i)
+    {
+        // Both heads read the same line, so the gains sum to one rather than
+        // keeping power, which would bump correlated material by 3 dB
+        auto position = static_cast<float>(i + 1) / static_cast<float>(fadeLength);
+        fadeIn[i] = static_cast<SampleType>(juce::square(PanLaw::getGain(position)));
+        fadeOut[i] = SampleType(1) - fadeIn[i];
+    }
+
+    for (int group = 0; group < max_groups; ++group)
+    {
+        auto size = static_cast<size_t>(group < this->numGroups ? this->maxBlockSize : 0);
+        timeRamp[group].allocate(size, true);
+        gainRamp[group].allocate(size, true);
+        tapSamples[group].allocate(size, true);
+        feedbackRamp[group].allocate(size, true);
+
+        // Room to align the interleaved lanes to a register
+        laneTimes[group].allocate(size * num_lanes, true);
+        laneFeedback[group].allocate(size * num_lanes, true);
+        laneSamples[group].allocate(size * num_lanes, true);
+        interleaved[group].allocate(size > 0 ? size * num_lanes + num_lanes : 0, true);
+        lfoValues[group].allocate(size * num_lanes, true);
+    }
+
+    reset();
+}
+
+// Snaps every ramp to its target, as juce::SmoothedValue::reset does
+template <typename SampleType>
+void TapEngine<SampleType>::reset()
+{
+    for (int i = 0; i < num_delays; ++i)
+    {
+        timeCurrent[i] = timeTarget[i] = timeQueued[i];
+        timeCountdown[i] = 0;
+        fadeCountdown[i] = 0;
+
+        feedbackCurrent[i] = feedbackTarget[i];
+        feedbackCountdown[i] = 0;
+
+        std::copy(&filterTarget[i][0][0], &filterTarget[i][0][0] + num_coefficients, &filterCoefficients[i][0][0]);
+        filterCountdown[i] = 0;
+        filterOn[i] = filterTargetOn[i];
+
+        for (int channel = 0; channel < max_channels; ++channel)
+        {
+            gainCurrent[channel][i] = gainTarget[channel][i];
+            gainCountdown[channel][i] = 0;
+        }
+    }
+
+    numActive = 0;
+    numFeedbackActive = 0;
+    feedbackRendered = false;
+
+    clearFilters();
+
+    for (auto& channel : allpassState)
+        std::fill(std::begin(channel), std::end(channel), SampleType(0));
+}
+
+template <typename SampleType>
+void TapEngine<SampleType>::clearFilters()
+{
+    for (auto& channel : filterState)
+        for (auto& tap : channel)
+            std::fill(std::begin(tap), std::end(tap), SampleType(0));
+}
+
+template <typename SampleType>
+void TapEngine<SampleType>::setTimeMode(TimeMode newMode)
+{
+    if (newMode == timeMode)
+        return;
+
+    for (int i = 0; i < num_delays; ++i)
+    {
+        if (newMode == TimeMode::crossfade)
+        {
+            // A moving ramp becomes a fade from where it has got to
+            fadeFrom[i] = timeCurrent[i];
+            fadeCountdown[i] = timeCurrent[i] != timeTarget[i] ? fadeLength : 0;
+            timeCurrent[i] = timeTarget[i];
+            timeCountdown[i] = 0;
+        }
+        else
+        {
+            // Ramp on from whichever head is louder
+            auto head = fadeCountdown[i] > fadeLength / 2 ? fadeFrom[i] : timeTarget[i];
+            timeCurrent[i] = timeTarget[i] = head;
+            timeCountdown[i] = 0;
+            fadeCountdown[i] = 0;
+            setRampTarget(timeCurrent[i], timeTarget[i], timeStep[i], timeCountdown[i], timeRampLength, timeQueued[i]);
+        }
+    }
+
+    timeMode = newMode;
+}
+
+template <typename SampleType>
+void TapEngine<SampleType>::setTarget(int tap, int delaySamples, const SampleType* gains, SampleType feedback,
+    SampleType fraction)
+{
+    timeQueued[tap] = delaySamples;
+    timeFraction[tap] = fraction;
+
+    if (timeMode == TimeMode::ramp)
+        setRampTarget(timeCurrent[tap], timeTarget[tap], timeStep[tap], timeCountdown[tap], timeRampLength, delaySamples);
+    else if (fadeCountdown[tap] <= 0 && delaySamples != timeTarget[tap])
+        startFade(tap);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        setRampTarget(gainCurrent[channel][tap], gainTarget[channel][tap], gainStep[channel][tap],
+            gainCountdown[channel][tap], gainRampLength, gains[channel]);
+
+    setRampTarget(feedbackCurrent[tap], feedbackTarget[tap], feedbackStep[tap], feedbackCountdown[tap],
+        gainRampLength, feedback);
+}
+
+template <typename SampleType>
+void TapEngine<SampleType>::setFilter(int tap, bool isOn, const FilterCoefficients& highPass, const FilterCoefficients& lowPass,
+    int rampLength)
+{
+    SampleType target [num_stages][5];
+    const FilterCoefficients* stages [num_stages] = { &highPass, &lowPass };
+
+    for (int stage = 0; stage < num_stages; ++stage)
+    {
+        auto& c = *stages[stage];
+        auto* dest = target[stage];
+
+        dest[0] = c[0] / c[3];
+        dest[1] = c[1] / c[3];
+        dest[2] = c[2] / c[3];
+        dest[3] = c[4] / c[3];
+        dest[4] = c[5] / c[3];
+    }
+
+    auto* first = &target[0][0];
+    auto* last = first + num_coefficients;
+
+    filterTargetOn[tap] = isOn;
+
+    std::copy(first, last, &filterTarget[tap][0][0]);
+
+    if (rampLength <= 0 || (!filterOn[tap] && !isOn))
+    {
+        // A filter switched on starts from silence
+        if (isOn && !filterOn[tap])
+            for (int channel = 0; channel < max_channels; ++channel)
+                std::fill(std::begin(filterState[channel][tap]), std::end(filterState[channel][tap]), SampleType(0));
+
+        std::copy(first, last, &filterCoefficients[tap][0][0]);
+        filterCountdown[tap] = 0;
+        filterOn[tap] = isOn;
+        return;
+    }
+
+    // A filter ramped on starts from silence, passing straight through
+    if (!filterOn[tap])
+    {
+        for (int channel = 0; channel < max_channels; ++channel)
+            std::fill(std::begin(filterState[channel][tap]), std::end(filterState[channel][tap]), SampleType(0));
+
+        for (auto& stage : filterCoefficients[tap])
+        {
+            std::fill(std::begin(stage), std::end(stage), SampleType(0));
+            stage[0] = SampleType(1);
+        }
+
+        filterOn[tap] = true;
+    }
+
+    filterCountdown[tap] = rampLength;
+
+    auto* current = &filterCoefficients[tap][0][0];
+    auto* step = &filterStep[tap][0][0];
+
+    for (int i = 0; i < num_coefficients; ++i)
+        step[i] = (first[i] - current[i]) / static_cast<SampleType>(rampLength);
+}
+
+template <typename SampleType>
+void TapEngine<SampleType>::setInterpolation(int tap, Interpolation kernel)
+{
+    if (kernel == interpolation[tap])
+        return;
+
+    interpolation[tap] = kernel;
+
+    for (auto& channel : allpassState)
+        channel[tap] = SampleType(0);
+}
+
+template <typename SampleType>
+void TapEngine<SampleType>::setModulation(int tap, float rateHertz, SampleType depthSamples)
+{
+    // The phase so far ran at the old rate
+    lfoPhase[tap] = getLfoPhase(tap);
+    lfoSince[tap] = lfoClock;
+    lfoIncrement[tap] = SineTable::getIncrement(rateHertz, lfoSampleRate);
+    lfoDepth[tap] = juce::jmax(SampleType(0), depthSamples);
+}
+
+template <typename SampleType>
+void TapEngine<SampleType>::setGains(int tap, const SampleType* gains, int rampLength)
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+        setRampTarget(gainCurrent[channel][tap], gainTarget[channel][tap], gainStep[channel][tap],
+            gainCountdown[channel][tap], rampLength, gains[channel]);
+}
+
+// Moves the incoming head to timeQueued and fades the current one out
+template <typename SampleType>
+void TapEngine<SampleType>::startFade(int tap)
+{
+    fadeFrom[tap] = timeTarget[tap];
+    timeCurrent[tap] = timeTarget[tap] = timeQueued[tap];
+    fadeCountdown[tap] = fadeLength;
+}
+
+// Moves a tap's delay time on by numSamples, in either mode. A crossfade that
+// ends starts the next one if the time changed while it ran.
+template <typename SampleType>
+void TapEngine<SampleType>::advanceTime(int tap, int numSamples)
+{
+    if (timeMode == TimeMode::ramp)
+    {
+        skipRamp(timeCurrent[tap], timeTarget[tap], timeStep[tap], timeCountdown[tap], numSamples);
+        return;
+    }
+
+    fadeCountdown[tap] = juce::jmax(0, fadeCountdown[tap] - numSamples);
+
+    if (fadeCountdown[tap] == 0 && timeQueued[tap] != timeTarget[tap])
+        startFade(tap);
+}
+
+// Collects the taps that can be heard this block, those that feed back
+// first. Silent taps only have their delay time advanced so they pick up
+// where they should when unmuted.
+template <typename SampleType>
+void TapEngine<SampleType>::buildActiveList(int numSamples)
+{
+    numActive = 0;
+
+    for (int i = 0; i < num_delays; ++i)
+    {
+        if (isSilent(i))
+            advanceTime(i, numSamples);
+        else if (feedsBack(i))
+            active[numActive++] = i;
+    }
+
+    numFeedbackActive = numActive;
+
+    for (int i = 0; i < num_delays; ++i)
+        if (!isSilent(i) && !feedsBack(i))
+            active[numActive++] = i;
+}
+
+// The groups ramp copies of the feedback gain, so it is moved on here, sample
+// by sample to land where they left it
+template <typename SampleType>
+void TapEngine<SampleType>::advanceFeedback(int tap, int numSamples)
+{
+    if (feedbackCountdown[tap] > 0)
+        fillRamp(feedbackCurrent[tap], feedbackTarget[tap], feedbackStep[tap], feedbackCountdown[tap],
+            feedbackRamp[0].get(), numSamples);
+}
+
+// Filter coefficients are ramped in the groups from the same start, so they
+// are moved on once here. Silent taps keep ramping so they do not pick up a
+// stale ramp when heard again.
+template <typename SampleType>
+void TapEngine<SampleType>::advanceFilters(int numSamples)
+{
+    for (int i = 0; i < num_delays; ++i)
+    {
+        if (filterCountdown[i] <= 0)
+            continue;
+
+        auto* current = &filterCoefficients[i][0][0];
+
+        if (numSamples >= filterCountdown[i])
+        {
+            std::copy(&filterTarget[i][0][0], &filterTarget[i][0][0] + num_coefficients, current);
+            filterCountdown[i] = 0;
+            filterOn[i] = filterTargetOn[i];
+            continue;
+        }
+
+        for (int c = 0; c < num_coefficients; ++c)
+            current[c] += (&filterStep[i][0][0])[c] * static_cast<SampleType>(numSamples);
+
+        filterCountdown[i] -= numSamples;
+    }
+}
+
+// Every tap's LFO runs, heard or not. Phases are worked out from the clock
+// when they are read, so only the clock moves here.
+template <typename SampleType>
+void TapEngine<SampleType>::advanceLfos(int numSamples)
+{
+    lfoClock += numSamples;
+}
+
+template <typename SampleType>
+int TapEngine<SampleType>::getLongestDelay() const
+{
+    int longest = 0;
+
+    for (int i = 0; i < num_delays; ++i)
+    {
+        if (isSilent(i))
+            continue;
+
+        auto tapLongest = juce::jmax(timeCurrent[i], timeTarget[i]);
+
+        if (fadeCountdown[i] > 0)
+            tapLongest = juce::jmax(tapLongest, fadeFrom[i]);
+
+        // Reads between samples reach as far as the kernel looks back
+        if (isFractional(i))
+            tapLongest += static_cast<int>(std::ceil(lfoDepth[i] + timeFraction[i]))
+                        + getInterpolationReach(interpolation[i]);
+
+        longest = juce::jmax(longest, tapLongest);
+    }
+
+    return longest;
+}
+
+template <typename SampleType>
+int TapEngine<SampleType>::getMaxFeedbackBlockSize() const
+{
+    auto longest = std::numeric_limits<int>::max();
+
+    for (int i = 0; i < num_delays; ++i)
+        longest = juce::jmin(longest, feedsBack(i) ? getFeedbackBlockSize(i) : getSamplesUntilFeedback(i));
+
+    return longest;
+}
+
+// Advances every ramp as process would, without reading the delay line. Used
+// when everything the taps could read is silence.
+template <typename SampleType>
+void TapEngine<SampleType>::skip(int numSamples)
+{
+    jassert(numSamples <= maxBlockSize);
+
+    numActive = 0;
+
+    for (int i = 0; i < num_delays; ++i)
+    {
+        advanceTime(i, numSamples);
+        advanceFeedback(i, numSamples);
+
+        // Gains step sample by sample so they land where process would leave them
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (gainCountdown[channel][i] > 0)
+                fillRamp(gainCurrent[channel][i], gainTarget[channel][i], gainStep[channel][i], gainCountdown[channel][i],
+                    gainRamp[0].get(), numSamples);
+    }
+
+    advanceFilters(numSamples);
+    advanceLfos(numSamples);
+}
+
+// Feedback taps read only samples written before this block, so they can be
+// rendered before it is. Must be called before the block is written.
+template <typename SampleType>
+bool TapEngine<SampleType>::processFeedback(const DelayLine<SampleType>& delayLine, juce::AudioBuffer<SampleType>& wetBuffer,
+    juce::AudioBuffer<SampleType>& feedbackBuffer, int numSamples, WorkerPool* workers)
+{
+    jassert(numSamples <= getMaxFeedbackBlockSize());
+    jassert(feedbackBuffer.getNumChannels() >= delayLine.getNumChannels());
+    jassert(wetBuffer.getNumChannels() == numChannels);
+
+    buildActiveList(numSamples);
+    feedbackRendered = true;
+
+    if (numFeedbackActive == 0)
+        return false;
+
+    blockLine = &delayLine;
+    blockWet = wetBuffer.getArrayOfWritePointers();
+    blockFeedback = feedbackBuffer.getArrayOfWritePointers();
+
+    auto numActiveTaps = numActive;
+    numActive = numFeedbackActive;
+    render(0, numSamples, workers);
+    numActive = numActiveTaps;
+
+    blockFeedback = nullptr;
+    return true;
+}
+
+// Reads every active tap from the delay line and accumulates into wetBuffer.
+// Must be called after the block has been written but before advancing.
+// @param numSamples - At most the maxBlockSize passed to prepare
+template <typename SampleType>
+void TapEngine<SampleType>::process(const DelayLine<SampleType>& delayLine, juce::AudioBuffer<SampleType>& wetBuffer, int numSamples,
+    WorkerPool* workers)
+{
+    jassert(wetBuffer.getNumChannels() == numChannels);
+
+    auto firstActive = feedbackRendered ? numFeedbackActive : 0;
+
+    if (!feedbackRendered)
+        buildActiveList(numSamples);
+
+    feedbackRendered = false;
+
+    blockLine = &delayLine;
+    blockWet = wetBuffer.getArrayOfWritePointers();
+    render(firstActive, numSamples, workers);
+
+    // The groups ramp copies of the delay times and feedback gains, so move
+    // them on once here
+    for (int a = 0; a < numActive; ++a)
+    {
+        advanceTime(active[a], numSamples);
+        advanceFeedback(active[a], numSamples);
+    }
+
+    advanceFilters(numSamples);
+    advanceLfos(numSamples);
+}
+
+// Runs the active taps from firstActive on, over every channel group
+template <typename SampleType>
+void TapEngine<SampleType>::render(int firstActive, int numSamples, WorkerPool* workers)
+{
+    jassert(numSamples <= juce::jmin(maxBlockSize, blockLine->getMaxReadLength()));
+
+    blockFirst = firstActive;
+    blockSamples = numSamples;
+
+    if (workers != nullptr && numGroups > 1)
+        workers->run(numGroups, runGroup, this);
+    else
+        for (int group = 0; group < numGroups; ++group)
+            processGroup(group);
+}
+
+template <typename SampleType>
+void TapEngine<SampleType>::runGroup(void* engine, int group)
+{
+    // Workers need the same denormal handling as the audio thread
+    juce::ScopedNoDenormals noDenormals;
+    static_cast<TapEngine*>(engine)->processGroup(group);
+}
+
+// Filtered taps are collected and run a register of lanes at a time
+template <typename SampleType>
+void TapEngine<SampleType>::processGroup(int group)
+{
+    auto startChannel = group * numChannels / numGroups;
+    auto endChannel = (group + 1) * numChannels / numGroups;
+
+    int filtered [num_lanes];
+    auto numFiltered = 0;
+
+    for (int a = blockFirst; a < numActive; ++a)
+    {
+        auto tap = active[a];
+
+        if (!filterOn[tap])
+        {
+            processTap(tap, group, startChannel, endChannel);
+            continue;
+        }
+
+        filtered[numFiltered++] = tap;
+
+        if (numFiltered == num_lanes)
+        {
+            processFilteredTaps(filtered, numFiltered, group, startChannel, endChannel);
+            numFiltered = 0;
+        }
+    }
+
+    if (numFiltered > 0)
+        processFilteredTaps(filtered, numFiltered, group, startChannel, endChannel);
+}
+
+// Accumulates one tap into a group's wet channels. Settled delay times are
+// read as one contiguous span, settled gains are applied as a constant and
+// silent channels are skipped. The last delay line channel, the only one for
+// a mono line, feeds every wet channel past it. While feedback is rendered,
+// each line channel's read is also sent back by the group that owns it.
+template <typename SampleType>
+void TapEngine<SampleType>::processTap(int tap, int group, int startChannel, int endChannel)
+{
+    auto numLineChannels = blockLine->getNumChannels();
+
+    auto* times = timeRamp[group].get();
+    auto* gains = gainRamp[group].get();
+    auto* gathered = tapSamples[group].get();
+    auto* feedbackGains = feedbackRamp[group].get();
+    auto* lfo = lfoValues[group].get();
+
+    auto numTimeRamp = fillTimeRamp(tap, times);
+    auto numFeedbackRamp = fillFeedbackRamp(tap, feedbackGains);
+    fillLfo(tap, lfo);
+
+    const SampleType* source = nullptr;
+    auto sourceChannel = -1;
+
+    // The allpass runs on every channel's own state, so a mono line is read
+    // again for each channel
+    auto isStateful = interpolation[tap] == Interpolation::allpass;
+
+    for (int channel = startChannel; channel < endChannel; ++channel)
+    {
+        auto isAudible = isChannelAudible(tap, channel);
+        auto isFedBack = blockFeedback != nullptr && channel < numLineChannels;
+
+        if (!isAudible && !isFedBack)
+        {
+            allpassState[channel][tap] = SampleType(0);
+            continue;
+        }
+
+        auto lineChannel = juce::jmin(channel, numLineChannels - 1);
+
+        if (lineChannel != sourceChannel || isStateful)
+        {
+            source = readTap(tap, lineChannel, times, numTimeRamp, lfo, allpassState[channel][tap], gathered);
+            sourceChannel = lineChannel;
+        }
+
+        addTap(tap, channel, source, isAudible, isFedBack, gains, feedbackGains, numFeedbackRamp);
+    }
+}
+
+// Same as processTap for up to num_lanes filtered taps, with the filters of
+// every tap run together on each channel. Filter state is per output
+// channel, so a mono line is filtered once for each channel that hears it.
+template <typename SampleType>
+void TapEngine<SampleType>::processFilteredTaps(const int* taps, int numTaps, int group, int startChannel, int endChannel)
+{
+    auto numLineChannels = blockLine->getNumChannels();
+    auto stride = maxBlockSize;
+
+    auto* gains = gainRamp[group].get();
+    auto* times = laneTimes[group].get();
+    auto* feedbackGains = laneFeedback[group].get();
+    auto* samples = laneSamples[group].get();
+    auto* lfo = lfoValues[group].get();
+
+    int numTimeRamp [num_lanes];
+    int numFeedbackRamp [num_lanes];
+
+    for (int lane = 0; lane < numTaps; ++lane)
+    {
+        numTimeRamp[lane] = fillTimeRamp(taps[lane], times + lane * stride);
+        numFeedbackRamp[lane] = fillFeedbackRamp(taps[lane], feedbackGains + lane * stride);
+        fillLfo(taps[lane], lfo + lane * stride);
+    }
+
+    for (int channel = startChannel; channel < endChannel; ++channel)
+    {
+        auto isFedBack = blockFeedback != nullptr && channel < numLineChannels;
+        auto lineChannel = juce::jmin(channel, numLineChannels - 1);
+
+        bool isAudible [num_lanes];
+        const SampleType* sources [num_lanes];
+        auto isHeard = false;
+
+        // A lane this channel does not hear reads silence from a cleared
+        // state, so it starts clean when it is heard again
+        for (int lane = 0; lane < numTaps; ++lane)
+        {
+            auto tap = taps[lane];
+            isAudible[lane] = isChannelAudible(tap, channel);
+
+            if (isAudible[lane] || isFedBack)
+            {
+                sources[lane] = readTap(tap, lineChannel, times + lane * stride, numTimeRamp[lane], lfo + lane * stride,
+                    allpassState[channel][tap], samples + lane * stride);
+                isHeard = true;
+            }
+            else
+            {
+                sources[lane] = nullptr;
+                std::fill(std::begin(filterState[channel][tap]), std::end(filterState[channel][tap]), SampleType(0));
+                allpassState[channel][tap] = SampleType(0);
+            }
+        }
+
+        if (!isHeard)
+            continue;
+
+        filterLanes(taps, numTaps, channel, sources, group);
+
+        for (int lane = 0; lane < numTaps; ++lane)
+            if (sources[lane] != nullptr)
+                addTap(taps[lane], channel, samples + lane * stride, isAudible[lane], isFedBack, gains,
+                    feedbackGains + lane * stride, numFeedbackRamp[lane]);
+    }
+}
+
+// The groups ramp copies of a tap's delay time, moved on once in process
+template <typename SampleType>
+int TapEngine<SampleType>::fillTimeRamp(int tap, int* times) const
+{
+    auto timeNow = timeCurrent[tap];
+    auto timeLeft = timeCountdown[tap];
+    return fillRamp(timeNow, timeTarget[tap], timeStep[tap], timeLeft, times, blockSamples);
+}
+
+template <typename SampleType>
+int TapEngine<SampleType>::fillFeedbackRamp(int tap, SampleType* feedbackGains) const
+{
+    if (blockFeedback == nullptr)
+        return 0;
+
+    auto feedbackNow = feedbackCurrent[tap];
+    auto feedbackLeft = feedbackCountdown[tap];
+    return fillRamp(feedbackNow, feedbackTarget[tap], feedbackStep[tap], feedbackLeft, feedbackGains, blockSamples);
+}
+
+// The LFO is only filled for taps it moves
+template <typename SampleType>
+void TapEngine<SampleType>::fillLfo(int tap, float* values) const
+{
+    if (lfoDepth[tap] > SampleType(0))
+        SineTable::fill(getLfoPhase(tap), lfoIncrement[tap], values, blockSamples);
+}
+
+// @return - The tap's samples from one line channel, in scratch unless the
+//           time is settled and they can be read in place
+// @param state - The allpass kernel's state for the channel being read
+template <typename SampleType>
+const SampleType* TapEngine<SampleType>::readTap(int tap, int lineChannel, const int* times, int numTimeRamp,
+    const float* lfo, SampleType& state, SampleType* scratch) const
+{
+    if (blockLine->isCompact())
+        return readTap(blockLine->getCompactView(), tap, lineChannel, times, numTimeRamp, lfo, state, scratch);
+
+    return readTap(*blockLine, tap, lineChannel, times, numTimeRamp, lfo, state, scratch);
+}
+
+// Reads through a full line's spans or a compact line's decoding view
+template <typename SampleType>
+template <typename Line>
+const SampleType* TapEngine<SampleType>::readTap(const Line& line, int tap, int lineChannel, const int* times,
+    int numTimeRamp, const float* lfo, SampleType& state, SampleType* scratch) const
+{
+    if (isFractional(tap))
+    {
+        switch (interpolation[tap])
+        {
+            case Interpolation::linear:
+                readFractional<Interpolation::linear>(line, tap, lineChannel, times, numTimeRamp, lfo, state, scratch);
+                break;
+
+            case Interpolation::cubic:
+                readFractional<Interpolation::cubic>(line, tap, lineChannel, times, numTimeRamp, lfo, state, scratch);
+                break;
+
+            case Interpolation::allpass:
+                readFractional<Interpolation::allpass>(line, tap, lineChannel, times, numTimeRamp, lfo, state, scratch);
+                break;
+
+            default:
+                readFractional<Interpolation::none>(line, tap, lineChannel, times, numTimeRamp, lfo, state, scratch);
+                break;
+        }
+
+        return scratch;
+    }
+
+    auto* source = readWhole(line, tap, lineChannel, times, numTimeRamp, scratch);
+
+    // An allpass at a whole delay passes its input straight through, so it
+    // picks up from the last sample if the delay moves off the sample again
+    if (interpolation[tap] == Interpolation::allpass)
+        state = source[blockSamples - 1];
+
+    return source;
+}
+
+template <typename SampleType>
+const SampleType* TapEngine<SampleType>::readWhole(const DelayLine<SampleType>& delayLine, int tap, int lineChannel,
+    const int* times, int numTimeRamp, SampleType* scratch) const
+{
+    auto numSamples = blockSamples;
+    auto readPosition = delayLine.getWritePosition();
+
+    if (fadeCountdown[tap] > 0)
+    {
+        // Crossfade the outgoing head into the incoming one
+        auto numFade = juce::jmin(numSamples, fadeCountdown[tap]);
+        auto offset = fadeLength - fadeCountdown[tap];
+        auto* incoming = delayLine.getReadPointer(lineChannel, readPosition - timeTarget[tap]);
+        auto* outgoing = delayLine.getReadPointer(lineChannel, readPosition - fadeFrom[tap]);
+
+        juce::FloatVectorOperations::multiply(scratch, incoming, fadeIn.get() + offset, numFade);
+        juce::FloatVectorOperations::addWithMultiply(scratch, outgoing, fadeOut.get() + offset, numFade);
+        juce::FloatVectorOperations::copy(scratch + numFade, incoming + numFade, numSamples - numFade);
+
+        return scratch;
+    }
+
+    if (numTimeRamp > 0)
+    {
+        // Moving delay time, gather one sample per read position
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            auto time = sample < numTimeRamp ? times[sample] : timeTarget[tap];
+            scratch[sample] = *delayLine.getReadPointer(lineChannel, readPosition + sample - time);
+        }
+
+        return scratch;
+    }
+
+    return delayLine.getReadPointer(lineChannel, readPosition - timeTarget[tap]);
+}
+
+// Same as above for a compact line, which always decodes into scratch
+template <typename SampleType>
+const SampleType* TapEngine<SampleType>::readWhole(const CompactView& delayLine, int tap, int lineChannel,
+    const int* times, int numTimeRamp, SampleType* scratch) const
+{
+    auto numSamples = blockSamples;
+    auto readPosition = delayLine.getWritePosition();
+
+    if (numTimeRamp > 0 && fadeCountdown[tap] == 0)
+    {
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            auto time = sample < numTimeRamp ? times[sample] : timeTarget[tap];
+            scratch[sample] = *delayLine.getReadPointer(lineChannel, readPosition + sample - time);
+        }
+
+        return scratch;
+    }
+
+    delayLine.read(lineChannel, readPosition - timeTarget[tap], scratch, numSamples);
+
+    if (fadeCountdown[tap] > 0)
+    {
+        auto numFade = juce::jmin(numSamples, fadeCountdown[tap]);
+        auto offset = fadeLength - fadeCountdown[tap];
+        auto outgoing = delayLine.getReadPointer(lineChannel, readPosition - fadeFrom[tap]);
+
+        juce::FloatVectorOperations::multiply(scratch, fadeIn.get() + offset, numFade);
+
+        for (int sample = 0; sample < numFade; ++sample)
+            scratch[sample] += outgoing[sample] * fadeOut[offset + sample];
+    }
+
+    return scratch;
+}
+
+// Reads a tap between samples with one kernel, at its fraction past the
+// whole delay plus the LFO swing. Ramping and crossfading heads are both
+// swung by the same LFO. An allpass cannot jump from one head to another, so
+// the outgoing head of a crossfade is read linearly.
+template <typename SampleType>
+template <Interpolation kernel, typename Line>
+void TapEngine<SampleType>::readFractional(const Line& delayLine, int tap, int lineChannel, const int* times,
+    int numTimeRamp, const float* lfo, SampleType& state, SampleType* scratch) const
+{
+    using Kernel = Interpolator<SampleType, kernel>;
+    using FadeKernel = Interpolator<SampleType, kernel == Interpolation::allpass ? Interpolation::linear : kernel>;
+
+    auto numSamples = blockSamples;
+    auto readPosition = delayLine.getWritePosition();
+    auto fraction = timeFraction[tap];
+    auto halfDepth = lfoDepth[tap] * SampleType(0.5);
+    auto isModulated = halfDepth > SampleType(0);
+
+    auto numFade = fadeCountdown[tap] > 0 ? juce::jmin(numSamples, fadeCountdown[tap]) : 0;
+    auto offset = fadeLength - fadeCountdown[tap];
+    auto fadeState = SampleType(0);
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        auto delay = isModulated ? fraction + halfDepth * (SampleType(1) + static_cast<SampleType>(lfo[sample]))
+                                 : fraction;
+        auto time = sample < numTimeRamp ? times[sample] : timeTarget[tap];
+        auto value = Kernel::read(delayLine, lineChannel, readPosition + sample, time, delay, state);
+
+        if (sample < numFade)
+            value = value * fadeIn[offset + sample]
+                  + FadeKernel::read(delayLine, lineChannel, readPosition + sample, fadeFrom[tap], delay, fadeState)
+                  * fadeOut[offset + sample];
+
+        scratch[sample] = value;
+    }
+}
+
+// Adds a tap to one wet channel with its ramped gain, and to the feedback
+template <typename SampleType>
+void TapEngine<SampleType>::addTap(int tap, int channel, const SampleType* source, bool isAudible, bool isFedBack,
+    SampleType* gains, const SampleType* feedbackGains, int numFeedbackRamp)
+{
+    auto numSamples = blockSamples;
+
+    if (isAudible)
+    {
+        auto numRamp = fillRamp(gainCurrent[channel][tap], gainTarget[channel][tap], gainStep[channel][tap],
+            gainCountdown[channel][tap], gains, numSamples);
+        auto* wet = blockWet[channel];
+
+        if (numRamp > 0)
+            juce::FloatVectorOperations::addWithMultiply(wet, source, gains, numRamp);
+
+        if (numRamp < numSamples)
+            juce::FloatVectorOperations::addWithMultiply(wet + numRamp, source + numRamp,
+                gainTarget[channel][tap], numSamples - numRamp);
+    }
+
+    if (isFedBack)
+    {
+        auto* feedback = blockFeedback[channel];
+
+        if (numFeedbackRamp > 0)
+            juce::FloatVectorOperations::addWithMultiply(feedback, source, feedbackGains, numFeedbackRamp);
+
+        if (numFeedbackRamp < numSamples)
+            juce::FloatVectorOperations::addWithMultiply(feedback + numFeedbackRamp, source + numFeedbackRamp,
+                feedbackTarget[tap], numSamples - numFeedbackRamp);
+    }
+}
+
+// Runs both biquad stages of up to num_lanes taps on one channel, one
+// register per sample, in transposed direct form II. A null source is
+// silence. The results replace each lane's samples. Coefficients still
+// ramping step every sample until their lane's ramp ends.
+template <typename SampleType>
+void TapEngine<SampleType>::filterLanes(const int* taps, int numTaps, int channel, const SampleType* const* sources, int group)
+{
+    auto numSamples = blockSamples;
+    auto stride = maxBlockSize;
+    auto* lanes = Vector::getNextSIMDAlignedPtr(interleaved[group].get());
+    auto* samples = laneSamples[group].get();
+
+    for (int lane = 0; lane < num_lanes; ++lane)
+    {
+        auto* source = lane < numTaps ? sources[lane] : nullptr;
+
+        for (int sample = 0; sample < numSamples; ++sample)
+            lanes[sample * num_lanes + lane] = source != nullptr ? source[sample] : SampleType(0);
+    }
+
+    for (int stage = 0; stage < num_stages; ++stage)
+    {
+        auto b0 = Vector::expand(SampleType(0)), b1 = b0, b2 = b0, a1 = b0, a2 = b0;
+        auto db0 = b0, db1 = b0, db2 = b0, da1 = b0, da2 = b0;
+        auto s1 = b0, s2 = b0;
+
+        // Samples each lane's coefficients ramp for in this block
+        int numRamp [num_lanes] = { 0 };
+
+        for (int lane = 0; lane < numTaps; ++lane)
+        {
+            auto tap = taps[lane];
+            auto* c = filterCoefficients[tap][stage];
+            auto* d = filterStep[tap][stage];
+            auto* state = filterState[channel][tap] + stage * 2;
+            auto index = static_cast<size_t>(lane);
+
+            b0.set(index, c[0]);
+            b1.set(index, c[1]);
+            b2.set(index, c[2]);
+            a1.set(index, c[3]);
+            a2.set(index, c[4]);
+            s1.set(index, state[0]);
+            s2.set(index, state[1]);
+
+            numRamp[lane] = juce::jmin(filterCountdown[tap], numSamples);
+
+            if (numRamp[lane] > 0)
+            {
+                db0.set(index, d[0]);
+                db1.set(index, d[1]);
+                db2.set(index, d[2]);
+                da1.set(index, d[3]);
+                da2.set(index, d[4]);
+            }
+        }
+
+        auto tick = [&] (int sample)
+        {
+            auto* frame = lanes + sample * num_lanes;
+            auto x = Vector::fromRawArray(frame);
+            auto y = b0 * x + s1;
+
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            y.copyToRawArray(frame);
+        };
+
+        auto sample = 0;
+
+        // Each step is taken from the start of the block rather than added
+        // up, so float coefficients do not drift off the ramp
+        auto from0 = b0, from1 = b1, from2 = b2, fromA1 = a1, fromA2 = a2;
+
+        // Ramps up to the next lane's end, where that lane lands on its target
+        for (;;)
+        {
+            auto end = numSamples + 1;
+
+            for (int lane = 0; lane < numTaps; ++lane)
+                if (numRamp[lane] > sample)
+                    end = juce::jmin(end, numRamp[lane]);
+
+            if (end > numSamples)
+                break;
+
+            for (; sample < end; ++sample)
+            {
+                auto position = Vector::expand(static_cast<SampleType>(sample + 1));
+                b0 = from0 + db0 * position;
+                b1 = from1 + db1 * position;
+                b2 = from2 + db2 * position;
+                a1 = fromA1 + da1 * position;
+                a2 = fromA2 + da2 * position;
+                tick(sample);
+            }
+
+            for (int lane = 0; lane < numTaps; ++lane)
+            {
+                if (numRamp[lane] != end)
+                    continue;
+
+                auto* c = filterTarget[taps[lane]][stage];
+                auto index = static_cast<size_t>(lane);
+
+                b0.set(index, c[0]);
+                b1.set(index, c[1]);
+                b2.set(index, c[2]);
+                a1.set(index, c[3]);
+                a2.set(index, c[4]);
+                from0.set(index, c[0]);
+                from1.set(index, c[1]);
+                from2.set(index, c[2]);
+                fromA1.set(index, c[3]);
+                fromA2.set(index, c[4]);
+                db0.set(index, SampleType(0));
+                db1.set(index, SampleType(0));
+                db2.set(index, SampleType(0));
+                da1.set(index, SampleType(0));
+                da2.set(index, SampleType(0));
+            }
+        }
+
+        for (; sample < numSamples; ++sample)
+            tick(sample);
+
+        for (int lane = 0; lane < numTaps; ++lane)
+        {
+            auto* state = filterState[channel][taps[lane]] + stage * 2;
+            state[0] = s1.get(static_cast<size_t>(lane));
+            state[1] = s2.get(static_cast<size_t>(lane));
+        }
+    }
+
+    for (int lane = 0; lane < numTaps; ++lane)
+        for (int sample = 0; sample < numSamples; ++sample)
+            samples[lane * stride + sample] = lanes[sample * num_lanes + lane];
+}
+
+//==============================================================================
+template class TapEngine<float>;
+template class TapEngine<double>;
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BlockRamp.h"
+#include "DelayLine.h"
+#include "Interpolation.h"
+#include "PanLaw.h"
+#include "SineTable.h"
+#include "WorkerPool.h"
+
+//==============================================================================
+// Number of delay taps, fixed at build time. Parameter IDs are delay1..delayN
+// etc. whatever the count, so sessions saved with another count still load
+// and missing taps stay at their silent defaults.
+#ifndef SEQUENCEDDELAY_NUM_TAPS
+ #define SEQUENCEDDELAY_NUM_TAPS 16
+#endif
+
+static constexpr int num_delays = SEQUENCEDDELAY_NUM_TAPS;
+static_assert(num_delays >= 1 && num_delays <= 128, "SEQUENCEDDELAY_NUM_TAPS must be between 1 and 128");
+
+//==============================================================================
+// Renders every delay tap from the shared delay line. Tap state is kept as
+// structure-of-arrays and only the taps that are currently audible are read.
+// Every output channel has its own gain per tap, and the channels can be
+// split into groups rendered in parallel. Instantiated for float and double
+// in TapEngine.cpp.
+template <typename SampleType>
+class TapEngine
+{
+public:
+    //==========================================================================
+    static constexpr int max_channels = ChannelPanner::max_channels;
+    static constexpr int max_groups = max_channels;
+
+    // Taps feed back only once their delay is at least this long, so the
+    // block never has to be split finer than this
+    static constexpr int min_feedback_delay = 32;
+
+    using Vector = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr int num_lanes = static_cast<int>(Vector::SIMDNumElements);
+
+    // b0, b1, b2, a0, a1, a2, as juce::dsp::IIR::ArrayCoefficients makes them
+    using FilterCoefficients = std::array<SampleType, 6>;
+
+    using CompactView = typename DelayLine<SampleType>::CompactView;
+
+    // Ramp moves the read position sample by sample, as
+    // juce::SmoothedValue<int> did. Crossfade fades between two fixed read
+    // heads, so a moving tap costs no more than a settled one.
+    enum class TimeMode
+    {
+        ramp,
+        crossfade
+    };
+
+    // @param numGroups - Channel groups process may run in parallel
+    void prepare(double sampleRate, int maxBlockSize, int numChannels, int numGroups = 1);
+    void reset();
+
+    // Switching mid-change hands the tap over from the head it is closest to
+    void setTimeMode(TimeMode newMode);
+    inline TimeMode getTimeMode() const { return timeMode; }
+
+    // The line is shared, so a tap-to-tap feedback matrix reduces to the one
+    // feedback gain per tap
+    // @param gains - One gain for each output channel
+    // @param feedback - Gain from the tap back into the delay line
+    // @param fraction - Part of a sample past delaySamples, 0 to 1
+    void setTarget(int tap, int delaySamples, const SampleType* gains, SampleType feedback = SampleType(0),
+        SampleType fraction = SampleType(0));
+
+    // Used while the tap's delay falls between samples or its LFO moves it,
+    // otherwise the tap reads whole samples
+    void setInterpolation(int tap, Interpolation kernel);
+
+    // Filtered taps run a SIMDRegister of taps per pass, the rest skip the
+    // filter loop entirely. A filter being switched on ramps from straight
+    // through, or starts from silence if it is not ramped.
+    // @param isOn - False passes the tap through unfiltered once the
+    //               coefficients have ramped to highPass and lowPass
+    // @param rampLength - Samples to interpolate the coefficients over, 0
+    //                     to set them at once
+    void setFilter(int tap, bool isOn, const FilterCoefficients& highPass, const FilterCoefficients& lowPass,
+        int rampLength = 0);
+
+    // The LFO never takes the delay below its set time, so feedback taps keep
+    // their minimum delay
+    // @param depthSamples - How far past its set time the LFO takes the delay,
+    //                       0 for a tap that reads whole samples
+    void setModulation(int tap, float rateHertz, SampleType depthSamples);
+
+    // Moves only the channel gains, over rampLength samples
+    void setGains(int tap, const SampleType* gains, int rampLength);
+
+    // @param offset - Samples ahead of the current phase
+    // @return - The tap's LFO, -1 to 1
+    inline float getLfoValue(int tap, int offset = 0) const
+    {
+        return SineTable::get(getLfoPhase(tap, offset));
+    }
+
+    // Renders the taps that feed back, adding what they send to the line
+    // into feedbackBuffer, before the block is written. process must follow.
+    // @param numSamples - At most getMaxFeedbackBlockSize()
+    // @return - False if no tap feeds back
+    bool processFeedback(const DelayLine<SampleType>& delayLine, juce::AudioBuffer<SampleType>& wetBuffer,
+        juce::AudioBuffer<SampleType>& feedbackBuffer, int numSamples, WorkerPool* workers = nullptr);
+
+    // Renders every tap processFeedback did not
+    // @param workers - Runs the channel groups in parallel, or nullptr
+    void process(const DelayLine<SampleType>& delayLine, juce::AudioBuffer<SampleType>& wetBuffer, int numSamples,
+        WorkerPool* workers = nullptr);
+    void skip(int numSamples);
+
+    inline int getNumActiveTaps() const { return numActive; }
+    inline int getNumGroups() const { return numGroups; }
+
+    // Longest delay, in samples, that an audible tap is reading or ramping to
+    int getLongestDelay() const;
+
+    // @return - Longest block the feedback taps can render before reading
+    //           samples of that block, and that ends where a tap starts
+    //           feeding back, or INT_MAX
+    int getMaxFeedbackBlockSize() const;
+
+private:
+    //==========================================================================
+    inline bool isSilent(int tap) const
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (gainTarget[channel][tap] != SampleType(0) || gainCountdown[channel][tap] > 0)
+                return false;
+
+        return feedbackTarget[tap] == SampleType(0) && feedbackCountdown[tap] == 0;
+    }
+
+    inline int getShortestDelay(int tap) const
+    {
+        auto shortest = juce::jmin(timeCurrent[tap], timeTarget[tap]);
+
+        if (fadeCountdown[tap] > 0)
+            shortest = juce::jmin(shortest, fadeFrom[tap]);
+
+        return shortest - getInterpolationLookahead(interpolation[tap]);
+    }
+
+    // A falling time ramp moves the read head closer to the write head every
+    // sample, so the block has to end before the two meet
+    inline int getFeedbackBlockSize(int tap) const
+    {
+        auto longest = getShortestDelay(tap);
+
+        if (timeCountdown[tap] > 0 && timeStep[tap] < 0)
+            longest = juce::jmin(longest, (timeCurrent[tap] - getInterpolationLookahead(interpolation[tap]))
+                / (1 - timeStep[tap]));
+
+        return juce::jmax(1, longest);
+    }
+
+    inline SineTable::Phase getLfoPhase(int tap, int offset = 0) const
+    {
+        return SineTable::advance(lfoPhase[tap], lfoIncrement[tap], lfoClock - lfoSince[tap] + offset);
+    }
+
+    inline bool isFractional(int tap) const
+    {
+        return lfoDepth[tap] > SampleType(0) || timeFraction[tap] != SampleType(0);
+    }
+
+    inline bool hasFeedback(int tap) const
+    {
+        return feedbackTarget[tap] != SampleType(0) || feedbackCountdown[tap] > 0;
+    }
+
+    inline bool feedsBack(int tap) const
+    {
+        return hasFeedback(tap) && getShortestDelay(tap) >= min_feedback_delay;
+    }
+
+    // A tap ramping up past min_feedback_delay starts feeding back at the
+    // sample it gets there, however the host splits its blocks
+    // @return - Samples until then, or INT_MAX if the ramp never gets there
+    inline int getSamplesUntilFeedback(int tap) const
+    {
+        auto lookahead = getInterpolationLookahead(interpolation[tap]);
+        auto distance = min_feedback_delay + lookahead - timeCurrent[tap];
+
+        if (!hasFeedback(tap) || timeCountdown[tap] <= 0 || timeTarget[tap] - lookahead < min_feedback_delay)
+            return std::numeric_limits<int>::max();
+
+        // A ramp whose step rounds to 0 jumps to its target on its last sample
+        if (timeStep[tap] <= 0)
+            return timeCountdown[tap];
+
+        return juce::jlimit(1, timeCountdown[tap], (distance + timeStep[tap] - 1) / timeStep[tap]);
+    }
+
+    inline bool isChannelAudible(int tap, int channel) const
+    {
+        return gainCountdown[channel][tap] > 0 || gainTarget[channel][tap] != SampleType(0);
+    }
+
+    void buildActiveList(int numSamples);
+    void advanceFeedback(int tap, int numSamples);
+    void advanceLfos(int numSamples);
+    void advanceFilters(int numSamples);
+    void render(int firstActive, int numSamples, WorkerPool* workers);
+    void clearFilters();
+    void advanceTime(int tap, int numSamples);
+    void startFade(int tap);
+
+    static void runGroup(void* engine, int group);
+    void processGroup(int group);
+    void processTap(int tap, int group, int startChannel, int endChannel);
+    void processFilteredTaps(const int* taps, int numTaps, int group, int startChannel, int endChannel);
+
+    // Per-tap pieces shared by both paths. Every read path is compiled for
+    // both kinds of storage; a compact line is decoded as it is read
+    int fillTimeRamp(int tap, int* times) const;
+    int fillFeedbackRamp(int tap, SampleType* feedbackGains) const;
+    void fillLfo(int tap, float* values) const;
+    const SampleType* readTap(int tap, int lineChannel, const int* times, int numTimeRamp, const float* lfo,
+        SampleType& state, SampleType* scratch) const;
+    template <typename Line>
+    const SampleType* readTap(const Line& line, int tap, int lineChannel, const int* times, int numTimeRamp,
+        const float* lfo, SampleType& state, SampleType* scratch) const;
+    const SampleType* readWhole(const DelayLine<SampleType>& delayLine, int tap, int lineChannel, const int* times,
+        int numTimeRamp, SampleType* scratch) const;
+    const SampleType* readWhole(const CompactView& delayLine, int tap, int lineChannel, const int* times,
+        int numTimeRamp, SampleType* scratch) const;
+    template <Interpolation kernel, typename Line>
+    void readFractional(const Line& delayLine, int tap, int lineChannel, const int* times, int numTimeRamp,
+        const float* lfo, SampleType& state, SampleType* scratch) const;
+    void addTap(int tap, int channel, const SampleType* source, bool isAudible, bool isFedBack, SampleType* gains,
+        const SampleType* feedbackGains, int numFeedbackRamp);
+    void filterLanes(const int* taps, int numTaps, int channel, const SampleType* const* sources, int group);
+
+    //==========================================================================
+    // Linear ramps mirror juce::SmoothedValue so the output is unchanged
+    int timeRampLength{ 0 };
+    int timeCurrent [num_delays] = { 0 };
+    int timeTarget [num_delays] = { 0 };
+    int timeStep [num_delays] = { 0 };
+    int timeCountdown [num_delays] = { 0 };
+
+    // Crossfade mode reads timeTarget and, while fadeCountdown runs, fades
+    // out the head at fadeFrom. timeQueued is the latest requested time,
+    // taken up once the fade ends.
+    TimeMode timeMode{ TimeMode::ramp };
+    int fadeLength{ 0 };
+    int fadeFrom [num_delays] = { 0 };
+    int fadeCountdown [num_delays] = { 0 };
+    int timeQueued [num_delays] = { 0 };
+
+    // Indexed by output channel, then tap
+    int gainRampLength{ 0 };
+    SampleType gainCurrent [max_channels][num_delays] = { { 0 } };
+    SampleType gainTarget [max_channels][num_delays] = { { 0 } };
+    SampleType gainStep [max_channels][num_delays] = { { 0 } };
+    int gainCountdown [max_channels][num_delays] = { { 0 } };
+
+    // Gain into the delay line, ramped like the channel gains
+    SampleType feedbackCurrent [num_delays] = { 0 };
+    SampleType feedbackTarget [num_delays] = { 0 };
+    SampleType feedbackStep [num_delays] = { 0 };
+    int feedbackCountdown [num_delays] = { 0 };
+
+    // Feedback taps come first; processFeedback renders those and leaves the
+    // rest to process
+    int active [num_delays] = { 0 };
+    int numActive{ 0 };
+    int numFeedbackActive{ 0 };
+    bool feedbackRendered{ false };
+
+    // High-pass then low-pass, each as b0, b1, b2, a1, a2 over a0. The state
+    // is per output channel so every group owns the state it runs. Each
+    // coefficient ramps linearly; a biquad's stable a1, a2 form a triangle,
+    // so every step between two stable filters is stable too. A filter being
+    // switched off keeps running until it has ramped to straight through.
+    static constexpr int num_stages = 2;
+    static constexpr int num_coefficients = num_stages * 5;
+    bool filterOn [num_delays] = { false };
+    bool filterTargetOn [num_delays] = { false };
+    SampleType filterCoefficients [num_delays][num_stages][5] = { { { 0 } } };
+    SampleType filterTarget [num_delays][num_stages][5] = { { { 0 } } };
+    SampleType filterStep [num_delays][num_stages][5] = { { { 0 } } };
+    int filterCountdown [num_delays] = { 0 };
+    SampleType filterState [max_channels][num_delays][num_stages * 2] = { { { 0 } } };
+
+    // Samples every LFO has run, and each tap's phase when the clock read
+    // lfoSince, its increment per sample and the delay swing
+    double lfoSampleRate{ 44100.0 };
+    juce::int64 lfoClock{ 0 };
+    juce::int64 lfoSince [num_delays] = { 0 };
+    SineTable::Phase lfoPhase [num_delays] = { 0 };
+    SineTable::Phase lfoIncrement [num_delays] = { 0 };
+    SampleType lfoDepth [num_delays] = { 0 };
+
+    // Part of a sample past the whole delay time, and how taps read it
+    SampleType timeFraction [num_delays] = { 0 };
+    Interpolation interpolation [num_delays] = { Interpolation::none };
+    SampleType allpassState [max_channels][num_delays] = { { 0 } };
+
+    int numChannels{ 0 };
+    int numGroups{ 1 };
+
+    //==========================================================================
+    // Block being rendered, read by every group
+    const DelayLine<SampleType>* blockLine = nullptr;
+    SampleType* const* blockWet = nullptr;
+    SampleType* const* blockFeedback = nullptr;
+    int blockSamples{ 0 };
+    int blockFirst{ 0 };
+
+    // Per-group ramp and gather scratch, sized for the maximum block
+    int maxBlockSize{ 0 };
+    juce::HeapBlock<int> timeRamp [max_groups];
+    juce::HeapBlock<SampleType> gainRamp [max_groups];
+    juce::HeapBlock<SampleType> tapSamples [max_groups];
+    juce::HeapBlock<SampleType> feedbackRamp [max_groups];
+
+    // Filtered taps, num_lanes at a time: each lane's ramps and samples, and
+    // the lanes interleaved one register per sample
+    juce::HeapBlock<int> laneTimes [max_groups];
+    juce::HeapBlock<SampleType> laneFeedback [max_groups];
+    juce::HeapBlock<SampleType> laneSamples [max_groups];
+    juce::HeapBlock<SampleType> interleaved [max_groups];
+
+    // LFO values of the taps being read, one lane's worth per filtered tap
+    juce::HeapBlock<float> lfoValues [max_groups];
+
+    // Equal-gain sine-squared fades for the incoming and outgoing heads
+    juce::HeapBlock<SampleType> fadeIn;
+    juce::HeapBlock<SampleType> fadeOut;
+};
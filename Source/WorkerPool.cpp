@@ -0,0 +1,228 @@
+#include "WorkerPool.h"
+
+#if JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#elif JUCE_WINDOWS
+ #define WIN32_LEAN_AND_MEAN
+ #define NOMINMAX
+ #include <windows.h>
+#else
+ #include <cerrno>
+ #include <semaphore.h>
+#endif
+
+//==============================================================================
+// dispatch_semaphore_signal, ReleaseSemaphore and sem_post only enter the
+// kernel to wake a waiter, and never take a lock a waiter could hold
+#if JUCE_MAC || JUCE_IOS
+struct WorkerPool::Semaphore::Native
+{
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    ~Native() { dispatch_release(semaphore); }
+    void post() { dispatch_semaphore_signal(semaphore); }
+    void wait() { dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER); }
+};
+#elif JUCE_WINDOWS
+struct WorkerPool::Semaphore::Native
+{
+    HANDLE semaphore = CreateSemaphoreW(nullptr, 0, WorkerPool::max_jobs, nullptr);
+    ~Native() { CloseHandle(semaphore); }
+    void post() { ReleaseSemaphore(semaphore, 1, nullptr); }
+    void wait() { WaitForSingleObject(semaphore, INFINITE); }
+};
+#else
+struct WorkerPool::Semaphore::Native
+{
+    sem_t semaphore;
+    Native() { sem_init(&semaphore, 0, 0); }
+    ~Native() { sem_destroy(&semaphore); }
+    void post() { sem_post(&semaphore); }
+    void wait() { while (sem_wait(&semaphore) != 0 && errno == EINTR) {} }
+};
+#endif
+
+WorkerPool::Semaphore::Semaphore() : native(std::make_unique<Native>()) {}
+WorkerPool::Semaphore::~Semaphore() = default;
+
+void WorkerPool::Semaphore::post() { native->post(); }
+void WorkerPool::Semaphore::wait() { native->wait(); }
+
+//==============================================================================
+WorkerPool::WorkerPool() = default;
+
+WorkerPool::~WorkerPool()
+{
+    release();
+}
+
+void WorkerPool::prepare(int numWorkers, double sampleRate, int blockSize)
+{
+    release();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* worker = workers.add(new Worker(*this));
+
+       #if SEQUENCEDDELAY_WORKGROUPS
+        worker->startRealtimeThread(juce::Thread::RealtimeOptions{}
+            .withApproximateAudioProcessingTime(blockSize, sampleRate));
+       #elif JUCE_MAJOR_VERSION >= 7
+        juce::ignoreUnused(sampleRate, blockSize);
+        worker->startThread(juce::Thread::Priority::highest);
+       #else
+        juce::ignoreUnused(sampleRate, blockSize);
+        worker->startThread(10);
+       #endif
+    }
+}
+
+void WorkerPool::release()
+{
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+
+    // Every sleeping worker wakes to see it should exit
+    for (int i = 0; i < workers.size(); ++i)
+        wakeUp.post();
+
+    for (auto* worker : workers)
+        worker->stopThread(1000);
+
+    workers.clear();
+    numSleeping = 0;
+}
+
+#if SEQUENCEDDELAY_WORKGROUPS
+void WorkerPool::setWorkgroup(const juce::AudioWorkgroup& newWorkgroup)
+{
+    const juce::SpinLock::ScopedLockType lock(workgroupLock);
+    workgroup = newWorkgroup;
+    ++workgroupVersion;
+}
+#endif
+
+//==============================================================================
+void WorkerPool::run(int numJobs, Job job, void* context)
+{
+    jassert(numJobs <= max_jobs);
+
+    if (numJobs <= 0)
+        return;
+
+    // The previous run has finished, so no worker reads these until the new
+    // state is published
+    currentJob = job;
+    currentContext = context;
+    numFinished.store(0, std::memory_order_relaxed);
+
+    auto generation = (state.load(std::memory_order_relaxed) >> 16) + 1;
+    state.store((generation << 16) | (static_cast<juce::uint64>(numJobs) << 8), std::memory_order_release);
+
+    // The caller takes a job itself. The fence pairs with the one in
+    // Worker::run, so the jobs are seen or the sleeper is.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeWorkers(numJobs - 1);
+
+    while (runNextJob())
+        ;
+
+    // Only jobs a worker has already claimed are left
+    while (numFinished.load(std::memory_order_acquire) < numJobs)
+        ;
+}
+
+// Each wake taken off numSleeping is one post, so a worker that found a job
+// after saying it would sleep at worst wakes once for nothing later
+void WorkerPool::wakeWorkers(int numWanted)
+{
+    for (int i = 0; i < numWanted; ++i)
+    {
+        auto sleeping = numSleeping.load(std::memory_order_seq_cst);
+
+        do
+        {
+            if (sleeping <= 0)
+                return;
+        }
+        while (!numSleeping.compare_exchange_weak(sleeping, sleeping - 1, std::memory_order_seq_cst));
+
+        wakeUp.post();
+    }
+}
+
+bool WorkerPool::runNextJob()
+{
+    auto current = state.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        auto next = static_cast<int>(current & 0xff);
+        auto count = static_cast<int>((current >> 8) & 0xff);
+
+        if (next >= count)
+            return false;
+
+        if (state.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            currentJob(currentContext, next);
+            numFinished.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+//==============================================================================
+WorkerPool::Worker::Worker(WorkerPool& p) : juce::Thread("SequencedDelay worker"), pool(p)
+{
+}
+
+// Looks for jobs briefly after each one, then sleeps until run() posts. A
+// worker says it will sleep before looking one last time, so a run()
+// published in between either finds it in numSleeping or is found by it.
+void WorkerPool::Worker::run()
+{
+    auto lastJob = juce::Time::getHighResolutionTicks();
+    auto spinTicks = juce::Time::secondsToHighResolutionTicks(idle_spin_microseconds * 1.0e-6);
+
+    while (!threadShouldExit())
+    {
+       #if SEQUENCEDDELAY_WORKGROUPS
+        if (pool.workgroupVersion.load() != joinedVersion)
+        {
+            const juce::SpinLock::ScopedLockType lock(pool.workgroupLock);
+            joinedVersion = pool.workgroupVersion.load();
+            token.reset();
+
+            if (pool.workgroup)
+                pool.workgroup.join(token);
+        }
+       #endif
+
+        if (pool.runNextJob())
+        {
+            lastJob = juce::Time::getHighResolutionTicks();
+            continue;
+        }
+
+        if (juce::Time::getHighResolutionTicks() - lastJob < spinTicks)
+            continue;
+
+        pool.numSleeping.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (pool.runNextJob())
+        {
+            // Take the count back unless run() already turned it into a post
+            auto sleeping = pool.numSleeping.load(std::memory_order_seq_cst);
+
+            while (sleeping > 0 && !pool.numSleeping.compare_exchange_weak(sleeping, sleeping - 1))
+                ;
+
+            lastJob = juce::Time::getHighResolutionTicks();
+            continue;
+        }
+
+        pool.wakeUp.wait();
+        lastJob = juce::Time::getHighResolutionTicks();
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Realtime threads and audio workgroups arrived in JUCE 7.0.6
+#if JUCE_VERSION >= 0x70006
+ #define SEQUENCEDDELAY_WORKGROUPS 1
+#else
+ #define SEQUENCEDDELAY_WORKGROUPS 0
+#endif
+
+//==============================================================================
+// Small preallocated pool that splits audio thread work into independent
+// jobs. run() hands out job indices through one atomic word; the calling
+// thread claims jobs too, so any job a worker has not picked up yet is run by
+// the caller and a sleeping worker never delays the block. The caller only
+// spins for jobs a worker is already running, so workers run as realtime
+// threads in the host's audio workgroup where JUCE supports it, and are not
+// preempted mid-job by ordinary threads. Idle workers sleep on a semaphore,
+// which run() posts without locking. Nothing locks or allocates outside
+// prepare(), release() and setWorkgroup().
+class WorkerPool
+{
+public:
+    //==========================================================================
+    using Job = void (*)(void* context, int index);
+
+    static constexpr int max_jobs = 255;
+
+    WorkerPool();
+    ~WorkerPool();
+
+    // Not real-time safe, starts numWorkers threads that each take up to one
+    // block of blockSize samples
+    void prepare(int numWorkers, double sampleRate, int blockSize);
+    void release();
+
+   #if SEQUENCEDDELAY_WORKGROUPS
+    // Workers join the workgroup the next time they look for a job
+    void setWorkgroup(const juce::AudioWorkgroup& newWorkgroup);
+   #endif
+
+    inline int getNumWorkers() const { return workers.size(); }
+
+    //==========================================================================
+    // Audio thread: runs job(context, i) for every i below numJobs and
+    // returns once all of them have finished
+    void run(int numJobs, Job job, void* context);
+
+private:
+    //==========================================================================
+    class Worker : public juce::Thread
+    {
+    public:
+        explicit Worker(WorkerPool& pool);
+        void run() override;
+
+    private:
+        WorkerPool& pool;
+
+       #if SEQUENCEDDELAY_WORKGROUPS
+        juce::WorkgroupToken token;
+        int joinedVersion{ 0 };
+       #endif
+    };
+
+    // Counting semaphore of the platform, posted without a lock
+    class Semaphore
+    {
+    public:
+        Semaphore();
+        ~Semaphore();
+
+        void post();
+        void wait();
+
+    private:
+        struct Native;
+        std::unique_ptr<Native> native;
+
+        JUCE_DECLARE_NON_COPYABLE (Semaphore)
+    };
+
+    // @return - True if a job was claimed and run
+    bool runNextJob();
+
+    // Audio thread: wakes up to numWanted sleeping workers
+    void wakeWorkers(int numWanted);
+
+    // Workers look for another job for this long before sleeping, enough to
+    // catch the next job of the same block but not the next block
+    static constexpr double idle_spin_microseconds = 20.0;
+
+    //==========================================================================
+    juce::OwnedArray<Worker> workers;
+
+    // Generation in the upper bits, then job count and next job index
+    std::atomic<juce::uint64> state{ 0 };
+    std::atomic<int> numFinished{ 0 };
+
+    // Workers that are or are about to be waiting on wakeUp
+    std::atomic<int> numSleeping{ 0 };
+    Semaphore wakeUp;
+
+    Job currentJob = nullptr;
+    void* currentContext = nullptr;
+
+   #if SEQUENCEDDELAY_WORKGROUPS
+    juce::SpinLock workgroupLock;
+    juce::AudioWorkgroup workgroup;
+    std::atomic<int> workgroupVersion{ 0 };
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE (WorkerPool)
+};